@@ -1,10 +1,46 @@
 #include "Humid.h"
+#include "ThisThread.h"
+
+TemperatureSensor::TemperatureSensor(PinName pin)
+    : humidSens(pin, kwin::DHT_MODEL_DHT22),
+      temperatureCalibration(kwin::LinearConversion<float>::identity()),
+      humidityCalibration(kwin::LinearConversion<float>::identity())
+{
+    this->humidSens.onComplete = [this]() { this->readCompleted.set(1); };
+}
 
 float TemperatureSensor::readTemperature(eScale Scale)
 {
-    this->humidSens->readData();
+    // Retry until a read succeeds, sleeping while the sensor isn't ready.
+    do {
+        ThisThread::sleep_for((this->humidSens.getTimeUntilReadyUs() + 999) / 1000);
+        this->readCompleted.clear(1);
+        this->humidSens.startRead();
+        this->readCompleted.wait_any(1);
+    } while (this->humidSens.getStatus() != kwin::DHT_COMPLETE);
+
+    const float celsius = this->temperatureCalibration.apply(
+        this->humidSens.getMeasurement().temperature);
 
-    while (this->humidSens->readData());
+    switch (Scale) {
+        case FARENHEIT:
+            return convertCelsiusToFahrenheit(celsius);
+        case KELVIN:
+            return convertCelsiusToKelvin(celsius);
+        default:
+            return celsius;
+    }
+}
 
-    return this->humidSens->ReadTemperature(Scale);
+float TemperatureSensor::readHumidity()
+{
+    return this->humidityCalibration.apply(
+        this->humidSens.getMeasurement().humidity);
+}
+
+void TemperatureSensor::setCalibration(kwin::LinearConversion<float> temperature,
+                                       kwin::LinearConversion<float> humidity)
+{
+    this->temperatureCalibration = temperature;
+    this->humidityCalibration = humidity;
 }
\ No newline at end of file
@@ -1,20 +1,32 @@
 #ifndef HUMID_H
 #define HUMID_H
 #include "DHT.h"
+#include "kwin/sensors/dhtReader.h"
+#include "kwin/utils/temperatureConversion.h"
 
 class TemperatureSensor 
 {
     private:
-        DHT *humidSens;
+        kwin::DhtReader humidSens;
+        EventFlags readCompleted;
+        kwin::LinearConversion<float> temperatureCalibration;
+        kwin::LinearConversion<float> humidityCalibration;
 
     public:
-        TemperatureSensor(PinName pin) 
-        { 
-            //Set pins of the humid sensor.
-            this->humidSens = new DHT(pin, AM2302); 
-        }
+        //Set pins of the humid sensor.
+        TemperatureSensor(PinName pin);
         
+        // Reads the sensor. Only the calling thread waits for the read, the
+        // CPU is free meanwhile.
         float readTemperature(eScale Scale);
+
+        // Returns the humidity from the latest readTemperature call.
+        float readHumidity();
+
+        // Sets the offset and gain correcting this sensor's readings. The
+        // temperature correction applies to degrees celsius.
+        void setCalibration(kwin::LinearConversion<float> temperature,
+                            kwin::LinearConversion<float> humidity);
 };
 
 #endif
\ No newline at end of file
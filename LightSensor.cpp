@@ -1,6 +1,47 @@
 #include "LightSensor.h"
+#include "kwin/utils/calibration.h"
+
+// Illuminance in lux at ADC readings of the photoresistor, which sits above a
+// 10 kOhm resistor to ground. The points follow a GL5528 type photoresistor
+// (10 kOhm at 10 lux, gamma 0.7): lux = 10 * (v / (1 - v))^(1 / 0.7). They sit
+// on entries of the table below, so those entries are exact, and are spaced
+// so interpolating between them stays within 0.5% of the curve, where the
+// table's own steps allow. Readings saturate above 0.99, about 7000 lux.
+static constexpr kwin::CalibrationPoint LUX_CALIBRATION_POINTS[] = {
+    {0.0f, 0.0f}, {0.0078125f, 0.009876f}, {0.01171875f, 0.01772f},
+    {0.015625f, 0.02689f}, {0.01953125f, 0.03719f}, {0.0234375f, 0.04853f},
+    {0.02734375f, 0.06083f}, {0.03125f, 0.07404f}, {0.0390625f, 0.103f},
+    {0.046875f, 0.1352f}, {0.0546875f, 0.1706f}, {0.06640625f, 0.2291f},
+    {0.078125f, 0.2943f}, {0.09375f, 0.3913f}, {0.109375f, 0.4999f},
+    {0.12890625f, 0.6525f}, {0.15234375f, 0.8613f}, {0.17578125f, 1.1f},
+    {0.203125f, 1.419f}, {0.23046875f, 1.786f}, {0.26171875f, 2.273f},
+    {0.29296875f, 2.841f}, {0.32421875f, 3.502f}, {0.359375f, 4.379f},
+    {0.39453125f, 5.423f}, {0.4296875f, 6.673f}, {0.46484375f, 8.177f},
+    {0.5f, 10.0f}, {0.53125f, 11.96f}, {0.5625f, 14.32f}, {0.59375f, 17.2f},
+    {0.62109375f, 20.26f}, {0.6484375f, 23.98f}, {0.67578125f, 28.55f},
+    {0.69921875f, 33.37f}, {0.72265625f, 39.28f}, {0.74609375f, 46.64f},
+    {0.765625f, 54.25f}, {0.78515625f, 63.69f}, {0.80078125f, 72.97f},
+    {0.81640625f, 84.29f}, {0.83203125f, 98.34f}, {0.84375f, 111.2f},
+    {0.85546875f, 126.8f}, {0.8671875f, 145.9f}, {0.87890625f, 169.7f},
+    {0.88671875f, 189.1f}, {0.89453125f, 212.0f}, {0.90234375f, 239.6f},
+    {0.91015625f, 273.3f}, {0.91796875f, 315.0f}, {0.92578125f, 367.9f},
+    {0.9296875f, 399.8f}, {0.93359375f, 436.4f}, {0.9375f, 478.8f},
+    {0.94140625f, 528.1f}, {0.9453125f, 586.3f}, {0.94921875f, 655.6f},
+    {0.953125f, 739.4f}, {0.95703125f, 842.2f}, {0.9609375f, 970.6f},
+    {0.96484375f, 1135.0f}, {0.96875f, 1351.0f}, {0.97265625f, 1644.0f},
+    {0.9765625f, 2061.0f}, {0.98046875f, 2689.0f}, {0.984375f, 3720.0f},
+    {0.98828125f, 5642.0f}, {0.99f, 7094.0f}};
+
+// Generated by the compiler, so it lives in flash.
+static constexpr kwin::CalibrationTable<8>
+    LUX_CALIBRATION_TABLE(LUX_CALIBRATION_POINTS);
 
 float LightSensor::readLight() 
 {
-    return this->lightSens->read(); // Below 0.005 in a dark room.
+    return this->lightSens.read(); // Below 0.005 in a dark room.
+}
+
+float LightSensor::readLux()
+{
+    return LUX_CALIBRATION_TABLE.lookup(this->lightSens.read_u16());
 }
\ No newline at end of file
@@ -5,11 +5,14 @@
 class LightSensor 
 {
     private:
-        AnalogIn *lightSens;
+        AnalogIn lightSens;
 
     public:
-        LightSensor() { this->lightSens = new AnalogIn(A0); }
+        LightSensor() : lightSens(A0) {}
         float readLight();
+
+        // Returns the illuminance in lux, linearized by a calibration table.
+        float readLux();
 };
 
 #endif
\ No newline at end of file
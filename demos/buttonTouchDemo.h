@@ -4,6 +4,9 @@
  */
 
 #include "kwin/controls/button.h"
+#include "kwin/graphics/lcdLayer.h"
+#include "kwin/utils/eventLoop.h"
+#include "kwin/utils/memoryPool.h"
 #include "stm32746g_discovery_lcd.h"
 #include "stm32746g_discovery_ts.h"
 #include <ThisThread.h>
@@ -12,7 +15,8 @@
 TS_StateTypeDef ts;          // Touch screen type definition.
 Serial serial(USBTX, USBRX); // USB serial connection.
 
-Thread uiThread;
+kwin::MbedClock eventClock;
+kwin::EventLoop<2> eventLoop(eventClock);
 
 int lastTouchX = 0; // Previous x-position of the touch input. variable used for
                     // button event determination.
@@ -20,6 +24,11 @@ int lastTouchY = 0; // Previous y-position of the touch input. variable used for
                     // button event determination.
 
 uint32_t PREFERRED_FPS = 16; // The preferred refresh rate for the UI.
+uint32_t INPUT_POLL_RATE = 60; // The rate at which the touch screen is read.
+
+kwin::ObjectPool<kwin::Button, 2> buttonPool; // Static memory for buttons.
+
+kwin::RetainedDisplay retainedDisplay; // Draws the changes between frames.
 
 kwin::Button *pButton;
 kwin::Button *pButton2;
@@ -42,111 +51,94 @@ void handleHumanInput() {
   lastTouchY = touchY;
 }
 
-clock_t begin_time;
-/* Method responsible for updating the UI.
- * (!) Should only be called once in it's own thread */
+/* Method responsible for drawing one frame of the UI.
+ * Run by the event loop at the preferred update rate (PREFERRED_FPS). */
 void updateUI() {
-  while (1) {
-
-    // Capture the current clock time.
-    begin_time = clock();
-
-    // Draw the UI elements
-    BSP_LCD_Clear(LCD_COLOR_DARKBLUE);
-    pButton->render();
-    pButton2->render();
-
-    /* Calculate how long the UI took to render, and wait so the update rate
-     * matches the preferred update rate (PREFFERED_FPS). */
-
-    // The amount of seconds it took to render the UI.
-    const auto secondsElapsed = float(clock() - begin_time) / CLOCKS_PER_SEC;
-
-    // A seconds is 1000000 microseconds.
-    const auto preferred_tick_duration_us = 1000000 / PREFERRED_FPS;
-
-    // The remaining amount of time to wait to satisfy the preferred framerate.
-    const auto delay = preferred_tick_duration_us - secondsElapsed;
-
-    wait_us(delay);
-  }
+  // Record the UI elements
+  kwin::DisplayList &displayList = retainedDisplay.beginFrame();
+  displayList.clear(LCD_COLOR_DARKBLUE);
+  pButton->render(displayList);
+  pButton2->render(displayList);
+
+  // Draw only what changed since the previous frame.
+  retainedDisplay.endFrame();
 }
 
-/* Method responsible for initializing the program components */
-void initialize() {
+/* Method responsible for making a button draggable and color coded.
+ * The listeners capture the button, so any amount of buttons can share it. */
+void configureDraggableButton(kwin::Button *button) {
+  // Only fire onHeld while dragging, and onNotPressed once per release.
+  button->suppressSteadyStateEvents = true;
 
-  /* Initialize and configure Button */
-  pButton = new kwin::Button(50, 50, 150, 150);
-  pButton->onPressed = [] {
+  button->onPressed = [button] {
     serial.printf("Pressed\n");
-    pButton->setBackgroundColor(LCD_COLOR_GREEN);
+    button->setBackgroundColor(LCD_COLOR_GREEN);
   };
-  pButton->onReleased = [] {
+  button->onReleased = [button] {
     serial.printf("Released\n");
-    pButton->setBackgroundColor(LCD_COLOR_RED);
+    button->setBackgroundColor(LCD_COLOR_RED);
   };
-  pButton->onHeld = [] {
+  button->onHeld = [button] {
     serial.printf("1\n");
-    pButton->setBackgroundColor(LCD_COLOR_YELLOW);
-    if (pButton->isPressed()) {
+    button->setBackgroundColor(LCD_COLOR_YELLOW);
+    if (button->isPressed()) {
       if (ts.touchDetected) {
-        pButton->setPosition(ts.touchX[0] - pButton->getWidth() / 2,
-                             ts.touchY[0] - pButton->getHeight() / 2);
+        button->setPosition(ts.touchX[0] - button->getWidth() / 2,
+                            ts.touchY[0] - button->getHeight() / 2);
       }
     }
   };
-  pButton->onNotPressed = [] {
+  button->onNotPressed = [button] {
     serial.printf("0\n");
-    pButton->setBackgroundColor(LCD_COLOR_CYAN);
+    button->setBackgroundColor(LCD_COLOR_CYAN);
   };
+}
+
+/* Method initializing the touch screen. Runs after the LCD is initialized,
+ * never alongside it: both initializations configure their pins with
+ * read-modify-writes of the same GPIO registers (GPIOH among others). */
+void initializeTouchScreen() {
+  BSP_TS_Init(BSP_LCD_GetXSize(), BSP_LCD_GetYSize());
+}
+
+/* Method responsible for initializing the program components */
+void initialize() {
+
+  /* Initialize and configure Button */
+  pButton = buttonPool.create(50, 50, 150, 150);
+  configureDraggableButton(pButton);
 
   /* Initialize and configure Button2 */
-  pButton2 = new kwin::Button(150, 150, 150, 150);
+  pButton2 = buttonPool.create(150, 150, 150, 150);
   pButton2->setTextColor(LCD_COLOR_ORANGE);
-  pButton2->onPressed = [] {
-    serial.printf("Pressed\n");
-    pButton2->setBackgroundColor(LCD_COLOR_GREEN);
-  };
-  pButton2->onReleased = [] {
-    serial.printf("Released\n");
-    pButton2->setBackgroundColor(LCD_COLOR_RED);
-  };
-  pButton2->onHeld = [] {
-    serial.printf("1\n");
-    pButton2->setBackgroundColor(LCD_COLOR_YELLOW);
-    if (pButton2->isPressed()) {
-      if (ts.touchDetected) {
-        pButton2->setPosition(ts.touchX[0] - pButton2->getWidth() / 2,
-                              ts.touchY[0] - pButton2->getHeight() / 2);
-      }
-    }
-  };
-  pButton2->onNotPressed = [] {
-    serial.printf("0\n");
-    pButton2->setBackgroundColor(LCD_COLOR_CYAN);
-  };
-
-  // Initialize the touch screen
-  BSP_TS_Init(BSP_LCD_GetXSize(), BSP_LCD_GetYSize());
+  configureDraggableButton(pButton2);
 
-  // Initialize the LCD
-  BSP_LCD_Init();
-  BSP_LCD_LayerDefaultInit(LTDC_ACTIVE_LAYER, LCD_FB_START_ADDRESS);
-  BSP_LCD_SelectLayer(LTDC_ACTIVE_LAYER);
+  // Initialize the LCD. The touch screen follows the first frame.
+  kwin::initializeLcdLayer();
 }
 
-/* Method responsible for starting the UI thread */
-void startUiThread() { uiThread.start(&updateUI); }
+/* Method responsible for registering the input and UI tasks */
+void startEventLoopTasks() {
+  eventLoop.addTimer("input", 1000000 / INPUT_POLL_RATE, &handleHumanInput);
+  eventLoop.addTimer("ui", 1000000 / PREFERRED_FPS, &updateUI);
+}
 
 // main method. Called once on boot
 int startDemo() {
 
   initialize();
-  startUiThread();
+  startEventLoopTasks();
 
-  while (true) {
-    handleHumanInput();
-  }
+  // Draw the first frame straight away, and report how long booting took.
+  updateUI();
+  serial.printf("First frame %lu us after boot\n",
+                (unsigned long)eventClock.nowUs());
+
+  // Input is only polled once the event loop runs.
+  initializeTouchScreen();
+
+  // Handle input and draw the UI forever, sleeping in between.
+  eventLoop.run();
 
   return 1; // Program exit planned/successful
 }
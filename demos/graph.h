@@ -1,110 +1,195 @@
-#include "deque"
-#include <sstream>
+#include <atomic>
+#include <math.h>
+#include <stdio.h>
 
 #include "mbed.h"
 #include "stm32746g_discovery_lcd.h"
 
 #include "DHT.h"
 #include "Humid.h"
+#include "LightSensor.h"
 #include "ThisThread.h"
+#include "kwin/graphics/displayList.h"
+#include "kwin/graphics/lcdLayer.h"
+#include "kwin/storage/blockStore.h"
+#include "kwin/storage/snapshotStore.h"
+#include "kwin/utils/alarms.h"
+#include "kwin/utils/calibration.h"
+#include "kwin/utils/eventLoop.h"
+#include "kwin/utils/memoryPool.h"
+#include "kwin/utils/ringBuffer.h"
+#include "kwin/utils/statistics.h"
+#include "kwin/utils/temperatureConversion.h"
+#include "kwin/utils/v1.h"
 
 // Flag to enable debug mode regarding the main dataset.
 // WARNING: If the dataset size is large this will drastically slow down the program.
 bool DEBUG_MODE_DATASET = false;
 
-typedef std::deque<float> Dataset;
+// Maximum amount of samples a dataset holds, 32 minutes at
+// SENSOR_INTERVAL_MS. Older samples are overwritten. Eight times the columns
+// a series is drawn with, MAX_ENVELOPE_COLUMNS, so the graph turns into a
+// min/max envelope as the datasets fill up.
+const int MAX_DATASET_SAMPLES = 960;
+
+typedef kwin::RingBuffer<float, MAX_DATASET_SAMPLES> Dataset;
+// The temperature samples, tagged with the unit they are stored in.
+typedef kwin::TemperatureHistory<float, Dataset> TemperatureDataset;
 
 float SCREEN_WIDTH;
 float SCREEN_HEIGHT;
-float temperature;
+kwin::Temperature<float> temperature;
+float humidity;
+float light;
+
+TemperatureDataset *temperatureDataset;
+Dataset *humidityDataset;
+Dataset *lightDataset;
+
+// Interval between sensor readings. The AM2302 needs at least 2 seconds.
+const uint32_t SENSOR_INTERVAL_MS = 2000;
+// Interval between polls of the serial line for commands.
+const uint32_t INPUT_INTERVAL_US = 100000;
+// Interval between frames.
+const uint32_t FRAME_INTERVAL_US = 100000;
+// Interval between CPU utilization reports on the serial line.
+const uint32_t REPORT_INTERVAL_US = 10000000;
 
 Serial serial(USBTX, USBRX);
 Thread temporatureSensorThread;
-TemperatureSensor *temperatureSensor = new TemperatureSensor(D4);
+
+// Static memory of the components that live for the whole program.
+const size_t COMPONENT_ARENA_BYTES = kwin::arenaBytesFor<TemperatureSensor>() +
+                                     kwin::arenaBytesFor<LightSensor>() +
+                                     kwin::arenaBytesFor<TemperatureDataset>() +
+                                     kwin::arenaBytesFor<Dataset>(2);
+kwin::Arena<COMPONENT_ARENA_BYTES> componentArena;
+
+TemperatureSensor *temperatureSensor;
+LightSensor *lightSensor;
+
+// Two point calibration of the AM2302: its readings at two reference
+// temperatures and humidities. Replace with the sensor's measured readings.
+constexpr kwin::LinearConversion<float> TEMPERATURE_CALIBRATION =
+    kwin::makeLinearCalibration({0.0f, 0.0f}, {40.0f, 40.0f});
+constexpr kwin::LinearConversion<float> HUMIDITY_CALIBRATION =
+    kwin::makeLinearCalibration({20.0f, 20.0f}, {80.0f, 80.0f});
+
+// Rolling statistics over the 100 most recent sensor readings.
+kwin::SlidingWindowStatistics<100> temperatureStatistics;
+kwin::SlidingWindowStatistics<100> lightStatistics;
+
+// Identifiers of the sensors the alarm rules apply to.
+enum SensorId { SENSOR_TEMPERATURE, SENSOR_LIGHT, SENSOR_COUNT };
+
+kwin::AlarmEngine<16, SENSOR_COUNT> alarmEngine;
 
 /**
- * @brief Initializes the LCD.
+ * @brief What the alarm banner shows. Published by the sensor thread, which
+ * owns the alarm engine, so drawing never reads the engine.
  *
  */
-void temperatureUpdateLoop() {
-  while (true) {
-    temperature = temperatureSensor->readTemperature(CELCIUS);
-  }
+struct AlarmBanner {
+  int ruleIndex;        // Rule of the most recently raised alarm that is
+                        // still active, -1 if none.
+  const char *ruleName; // Name of that rule, NULL if none.
+  int activeAlarmCount; // Amount of active alarms.
+};
+kwin::Snapshot<AlarmBanner> alarmBanner;
+
+/**
+ * @brief Publishes the alarm engine's state for the banner. Call from the
+ * thread updating the engine.
+ *
+ */
+void publishAlarmBanner() {
+  AlarmBanner banner;
+  banner.ruleIndex = alarmEngine.getLatestActiveRuleIndex();
+  banner.ruleName =
+      banner.ruleIndex >= 0 ? alarmEngine.getRule(banner.ruleIndex).name : NULL;
+  banner.activeAlarmCount = alarmEngine.getActiveAlarmCount();
+  alarmBanner.publish(banner);
 }
 
+kwin::MbedClock eventClock;
+kwin::EventLoop<5> eventLoop(eventClock);
+int sampleEvent; // Posted by the sensor thread after every reading.
+
 /**
- * @brief Initializes the LCD.
+ * @brief Configures the alarm rules of the greenhouse. Runs on the sensor
+ * thread, before its first read.
  *
  */
-void initializeScreen() {
-  // Initialize the LCD
-  BSP_LCD_Init();
-  BSP_LCD_LayerDefaultInit(LTDC_ACTIVE_LAYER, LCD_FB_START_ADDRESS);
-  BSP_LCD_SelectLayer(LTDC_ACTIVE_LAYER);
+void initializeAlarms() {
+  //                   name, sensor, kind, threshold, hysteresis, duration
+  alarmEngine.addRule({"Too hot", SENSOR_TEMPERATURE, kwin::ALARM_ABOVE, 35.0f,
+                       1.0f, 10000});
+  alarmEngine.addRule({"Too cold", SENSOR_TEMPERATURE, kwin::ALARM_BELOW, 5.0f,
+                       1.0f, 10000});
+  alarmEngine.addRule({"Heating fast", SENSOR_TEMPERATURE,
+                       kwin::ALARM_RISE_RATE, 0.5f, 0.2f, 5000});
+  alarmEngine.addRule({"Dark", SENSOR_LIGHT, kwin::ALARM_BELOW, 1.0f, 1.0f,
+                       60000});
 
-  SCREEN_WIDTH = BSP_LCD_GetXSize();
-  SCREEN_HEIGHT = BSP_LCD_GetYSize();
+  alarmEngine.onAlarm = [](const kwin::AlarmEvent &event) {
+    serial.printf("%s %s\n", alarmEngine.getRule(event.ruleIndex).name,
+                  event.raised ? "raised" : "cleared");
+    // Runs on the sensor thread, which owns the engine's state.
+    publishAlarmBanner();
+  };
+  alarmEngine.compile();
+  // No alarm is active yet. Runs on the sensor thread, like the later
+  // publishes.
+  publishAlarmBanner();
 }
 
+void writeSnapshotFlash();
+
 /**
- * @brief Returns the smallest sample value from a dataset.
+ * @brief Periodically reads the temperature, humidity and light sensors, and
+ * posts 'sampleEvent' after every reading.
  *
- * @param dataset The dataset which to find the smallest value of.
- * @return float The smallest value in the dataset.
  */
-float minimalDatasetSampleValue(Dataset *dataset) {
-  // There are no samples.
-  if (dataset->empty()) {
-    return NULL; // Alternatively throw exception.
-  }
+void temperatureUpdateLoop() {
+  while (true) {
+    temperature = kwin::Temperature<float>(
+        temperatureSensor->readTemperature(CELCIUS), kwin::UNIT_CELSIUS);
+    humidity = temperatureSensor->readHumidity();
+    light = lightSensor->readLux();
 
-  // There is only 1 sample.
-  if (dataset->size() == 1) {
-    return dataset->at(0);
-  }
+    temperatureStatistics.add(temperature.in(temperatureDataset->getUnit()));
+    lightStatistics.add(light);
 
-  float minimalSampleValue = dataset->at(0);
-  const int datasetSize = dataset->size();
+    const uint32_t timeMs = Kernel::get_ms_count();
+    // The alarm thresholds are in celsius.
+    alarmEngine.update(SENSOR_TEMPERATURE, temperature.in(kwin::UNIT_CELSIUS),
+                       timeMs);
+    alarmEngine.update(SENSOR_LIGHT, light, timeMs);
 
-  // Loop though the dataset.
-  for (int i = 1; i < datasetSize; ++i) {
-    const float currentSampleValue = dataset->at(i);
-    if (currentSampleValue < minimalSampleValue) {
-      minimalSampleValue = currentSampleValue;
-    }
+    eventLoop.post(sampleEvent);
+
+    // Flash is written between reads, so it never stalls one.
+    writeSnapshotFlash();
+    ThisThread::sleep_for(SENSOR_INTERVAL_MS);
   }
-  return minimalSampleValue;
 }
 
 /**
- * @brief Returns the largest sample value from a dataset.
+ * @brief Initializes the LCD.
  *
- * @param dataset The dataset which to find the largest value of.
- * @return float The largest value in the dataset.
  */
-float maximalDatasetSampleValue(Dataset *dataset) {
-  // There are no samples.
-  if (dataset->empty()) {
-    return NULL; // Alternatively throw exception.
-  }
-
-  // There is only 1 sample.
-  if (dataset->size() == 1) {
-    return dataset->at(0);
-  }
+void initializeScreen() {
+  // Initialize the LCD
+  kwin::initializeLcdLayer();
 
-  // Loop though the dataset.
-  float maximalSampleValue = dataset->at(0);
-  const float datasetSize = dataset->size();
-  for (int i = 1; i < datasetSize; ++i) {
-    const float currentSampleValue = dataset->at(i);
-    if (currentSampleValue > maximalSampleValue) {
-      maximalSampleValue = currentSampleValue;
-    }
-  }
-  return maximalSampleValue;
+  SCREEN_WIDTH = BSP_LCD_GetXSize();
+  SCREEN_HEIGHT = BSP_LCD_GetYSize();
 }
 
+// Frames are recorded into 'display', and only the changes are drawn.
+kwin::RetainedDisplay retainedDisplay;
+kwin::DisplayList *display = NULL;
+
 /**
  * @brief Converts a number into a c-string.
  *
@@ -112,10 +197,10 @@ float maximalDatasetSampleValue(Dataset *dataset) {
  * @return uint8_t* The number as a c-string.
  */
 template <typename T> uint8_t *numberToUInt8Array(T number) {
-  stringstream strs;
-  strs << number;
-  string tempStr = strs.str();
-  return (uint8_t *)tempStr.c_str();
+  // Static, so converting doesn't allocate. Valid until the next call.
+  static char text[16];
+  snprintf(text, sizeof(text), "%g", (double)number);
+  return (uint8_t *)text;
 }
 
 /**
@@ -191,91 +276,421 @@ void drawIndicatorLines(float x, float y, float width, float height,
     uint8_t *indicatorValueText = numberToUInt8Array(indicatorValue);
 
     // Draw the indicator line.
-    BSP_LCD_DrawHLine(indicatorXConstrained, indicatorLineYConstrained, width);
+    display->drawHLine(indicatorXConstrained, indicatorLineYConstrained,
+                       width);
 
     // Draw the indicator line text.
-    BSP_LCD_DisplayStringAt(indicatorXConstrained, indicatorTextYConstrained,
-                            indicatorValueText, LEFT_MODE);
+    display->displayStringAt(indicatorXConstrained, indicatorTextYConstrained,
+                             indicatorValueText, LEFT_MODE);
   }
 }
 
+// Maximum amount of series a multi-series graph can draw.
+const int MAX_SERIES = 4;
+
+// Amount of indicator lines of the graph.
+const int INDICATOR_LINES = 5;
+
+// Draw commands a frame records besides the series: the clear, the grid
+// lines and their labels, the labels of up to MAX_SERIES - 1 right axes, two
+// statistics lines and the alarm banner's fill and text.
+const int GRAPH_FIXED_COMMANDS =
+    1 + 2 * INDICATOR_LINES + (MAX_SERIES - 1) * INDICATOR_LINES + 2 + 2;
+
+// Maximum amount of columns the envelope renderer bins a series into. Every
+// column records one draw command, as does every line of a series with fewer
+// samples, so all series fit the display list next to the rest of the frame.
+// Otherwise a frame would overflow the list and lose its diffing.
+const int MAX_ENVELOPE_COLUMNS =
+    (KWIN_DISPLAY_LIST_MAX_COMMANDS - GRAPH_FIXED_COMMANDS) / MAX_SERIES;
+static_assert(MAX_SERIES * MAX_ENVELOPE_COLUMNS + GRAPH_FIXED_COMMANDS <=
+                  KWIN_DISPLAY_LIST_MAX_COMMANDS,
+              "A frame of the graph overflows the display list");
+static_assert(MAX_ENVELOPE_COLUMNS >= 100,
+              "Too few columns per series, raise "
+              "KWIN_DISPLAY_LIST_MAX_COMMANDS");
+
+/**
+ * @brief Summary of all the samples that fall within one column.
+ *
+ */
+struct EnvelopeColumn {
+  float minimalSampleValue; // Smallest sample value within the column.
+  float maximalSampleValue; // Largest sample value within the column.
+  float lastSampleValue;    // Newest sample value within the column.
+};
+
+// Column bins used by the envelope renderer, one row per series so every
+// series is binned once per frame. Kept static to avoid heap usage per frame.
+EnvelopeColumn envelopeColumns[MAX_SERIES][MAX_ENVELOPE_COLUMNS];
+
 /**
- * @brief Draws a dataset on the LCD.
+ * @brief Bins the samples of a dataset into columns in a single pass, finding
+ * the extrema of the dataset on the way. Datasets holding fewer samples than
+ * 'maxColumnCount' get one sample per column.
  *
- * @param dataset The dataset which to draw.
+ * @param dataset The dataset to bin. Must not be empty.
+ * @param columns Output for the columns, MAX_ENVELOPE_COLUMNS at most.
+ * @param maxColumnCount Amount of columns to bin the samples into at most.
+ * @param minimalSampleValue Output for the smallest sample value.
+ * @param maximalSampleValue Output for the largest sample value.
+ * @return int Amount of columns the samples were binned into.
+ */
+int binDatasetIntoColumns(const Dataset *dataset, EnvelopeColumn *columns,
+                          int maxColumnCount, float *minimalSampleValue,
+                          float *maximalSampleValue) {
+  const int datasetSize = dataset->size();
+
+  int columnCount = maxColumnCount;
+  if (columnCount > MAX_ENVELOPE_COLUMNS) {
+    columnCount = MAX_ENVELOPE_COLUMNS;
+  }
+  if (columnCount > datasetSize) {
+    columnCount = datasetSize;
+  }
+  if (columnCount < 1) {
+    columnCount = 1;
+  }
+
+  float minimalValue = dataset->front();
+  float maximalValue = dataset->front();
+
+  // Sample i belongs to column i * columnCount / datasetSize. Instead of
+  // dividing per sample, 'threshold' holds i * columnCount - column *
+  // datasetSize, and sample i starts the next column once it reaches
+  // datasetSize. There are at least as many samples as columns, so a sample
+  // moves on by one column at most.
+  EnvelopeColumn *bin = columns;
+  bin->minimalSampleValue = minimalValue;
+  bin->maximalSampleValue = maximalValue;
+  int threshold = 0;
+  for (Dataset::const_iterator it = dataset->begin(); it != dataset->end();
+       ++it) {
+    const float currentSampleValue = *it;
+
+    if (threshold >= datasetSize) { // First sample of a new column.
+      threshold -= datasetSize;
+      ++bin;
+      bin->minimalSampleValue = currentSampleValue;
+      bin->maximalSampleValue = currentSampleValue;
+    } else if (currentSampleValue < bin->minimalSampleValue) {
+      bin->minimalSampleValue = currentSampleValue;
+    } else if (currentSampleValue > bin->maximalSampleValue) {
+      bin->maximalSampleValue = currentSampleValue;
+    }
+    bin->lastSampleValue = currentSampleValue;
+    threshold += columnCount;
+
+    if (currentSampleValue < minimalValue) {
+      minimalValue = currentSampleValue;
+    } else if (currentSampleValue > maximalValue) {
+      maximalValue = currentSampleValue;
+    }
+  }
+
+  *minimalSampleValue = minimalValue;
+  *maximalSampleValue = maximalValue;
+  return columnCount;
+}
+
+/**
+ * @brief Draws the columns binned by binDatasetIntoColumns as one span per
+ * column, as wide as the column, in the current text color.
+ *
+ * @param columns The binned columns.
+ * @param columnCount Amount of binned columns.
  * @param x x-axis offset of the diagram.
- * @param y x-axis offset of the diagram.
+ * @param y y-axis offset of the diagram.
  * @param width Width of diagram.
  * @param height Height of diagram.
- * @param indicatorLines Amount of indicator lines the diagram should have.
+ * @param lowestValue Sample value drawn at the bottom of the diagram.
+ * @param highestValue Sample value drawn at the top of the diagram.
+ */
+void drawEnvelopeColumns(const EnvelopeColumn *columns, int columnCount,
+                         float x, float y, float width, float height,
+                         float lowestValue, float highestValue) {
+  const float sampleValueRange = highestValue - lowestValue;
+  // Prevent division by zero when all samples have the same value.
+  const float heightPerValue =
+      sampleValueRange > 0.0f ? height / sampleValueRange : 0.0f;
+  const float columnWidth = width / columnCount;
+
+  float previousLastSampleValue = columns[0].lastSampleValue;
+  for (int i = 0; i < columnCount; ++i) {
+    const EnvelopeColumn &bin = columns[i];
+
+    // Extend the span towards the previous column's last value, so the graph
+    // stays connected when it jumps between columns.
+    float spanLowValue = bin.minimalSampleValue;
+    float spanHighValue = bin.maximalSampleValue;
+    if (previousLastSampleValue < spanLowValue) {
+      spanLowValue = previousLastSampleValue;
+    } else if (previousLastSampleValue > spanHighValue) {
+      spanHighValue = previousLastSampleValue;
+    }
+
+    const float spanTop =
+        y + height - (spanHighValue - lowestValue) * heightPerValue;
+    const float spanBottom =
+        y + height - (spanLowValue - lowestValue) * heightPerValue;
+
+    const uint16_t spanLeft = x + i * columnWidth;
+    const uint16_t spanRight = x + (i + 1) * columnWidth;
+    display->fillRect(spanLeft, spanTop, kwin::max(spanRight - spanLeft, 1),
+                      (uint16_t)(spanBottom - spanTop) + 1);
+
+    previousLastSampleValue = bin.lastSampleValue;
+  }
+}
+
+/**
+ * @brief A dataset drawn as one line of a multi-series graph.
+ *
  */
-void drawLineGraph(Dataset *dataset, float x, float y, float width,
-                   float height, int indicatorLines) {
-  // If dataset is empty there is nothing to draw.
-  if (dataset->empty()) {
+struct Series {
+  const Dataset *dataset; // The samples of the series.
+  uint32_t color;         // Line and axis label color of the series.
+  bool hasOwnAxis; // If true the series is scaled to its own extrema and
+                   // labelled on the right. Otherwise it shares the left axis.
+  kwin::LinearConversion<float>
+      displayConversion; // Converts sample values to the unit of the labels.
+};
+
+/**
+ * @brief Draws the columns of a binned dataset in the current text color,
+ * scaled to the given value range. Columns summarizing several samples are
+ * drawn as a min/max envelope, otherwise the samples are connected by lines.
+ *
+ * @param columns The columns binned by binDatasetIntoColumns.
+ * @param columnCount Amount of binned columns.
+ * @param sampleCount Amount of samples binned into the columns.
+ * @param x x-axis offset of the diagram.
+ * @param y y-axis offset of the diagram.
+ * @param width Width of diagram.
+ * @param height Height of diagram.
+ * @param lowestValue Sample value drawn at the bottom of the diagram.
+ * @param highestValue Sample value drawn at the top of the diagram.
+ */
+void plotColumns(const EnvelopeColumn *columns, int columnCount,
+                 int sampleCount, float x, float y, float width, float height,
+                 float lowestValue, float highestValue) {
+  if (columnCount < 1) {
     return;
   }
 
-  const float minimalSampleValue = minimalDatasetSampleValue(dataset);
-  const float maximalSampleValue = maximalDatasetSampleValue(dataset);
-  const float datasetSize = dataset->size();
+  if (sampleCount > columnCount) {
+    drawEnvelopeColumns(columns, columnCount, x, y, width, height, lowestValue,
+                        highestValue);
+    return;
+  }
 
-  //// Draw Indicator lines
-  BSP_LCD_SetBackColor(LCD_COLOR_BLACK);
-  BSP_LCD_SetTextColor(LCD_COLOR_WHITE);
-  drawIndicatorLines(x, y, width, height, minimalSampleValue,
-                     maximalSampleValue, indicatorLines);
+  const float sampleValueRange = highestValue - lowestValue;
+  // Prevent division by zero when all samples have the same value.
+  const float heightPerValue =
+      sampleValueRange > 0.0f ? height / sampleValueRange : 0.0f;
+  const float poleWidth = width / columnCount;
 
-  ////Draw data lines
-  for (int i = 0; i < datasetSize; ++i) {
+  float previousPoleHeight =
+      (columns[0].lastSampleValue - lowestValue) * heightPerValue;
+  for (int i = 0; i < columnCount; ++i) {
+    const float currentPoleHeight =
+        (columns[i].lastSampleValue - lowestValue) * heightPerValue;
+    display->drawLine(x + i * poleWidth, y + height - previousPoleHeight,
+                      x + (i + 1) * poleWidth, y + height - currentPoleHeight);
+    previousPoleHeight = currentPoleHeight;
+  }
+}
 
-    const float currentSampleValue = dataset->at(i);
-    const float currentPoleHeight = height /
-                                    (maximalSampleValue - minimalSampleValue) *
-                                    (currentSampleValue - minimalSampleValue);
+/**
+ * @brief Draws the indicator labels of a separate axis along the right edge
+ * of a diagram, without drawing any lines.
+ *
+ * @param right x-axis coordinate of the right edge of the diagram.
+ * @param y y-axis offset of the diagram.
+ * @param height Height of the diagram.
+ * @param lowestValue Lowest indicator value.
+ * @param highestValue Highest indicator value.
+ * @param amountOfIndicatorLines Amount of indicator labels to draw.
+ * @param rowOffset y-axis offset of the labels, so several axes don't overlap.
+ */
+void drawIndicatorLabels(float right, float y, float height, float lowestValue,
+                         float highestValue, int amountOfIndicatorLines,
+                         int rowOffset) {
+  const int actualAmountOfIndicatorLines = amountOfIndicatorLines - 1;
+  const float indicatorLineSpacing = height / actualAmountOfIndicatorLines;
+  const float indicatorValueDelta =
+      (highestValue - lowestValue) / actualAmountOfIndicatorLines;
+
+  // RIGHT_MODE positions text relative to the right edge of the screen.
+  uint16_t distanceFromRightEdge = 0;
+  if (right < SCREEN_WIDTH) {
+    distanceFromRightEdge = SCREEN_WIDTH - right;
+  }
+
+  for (int i = 0; i <= actualAmountOfIndicatorLines; ++i) {
+    // The first label is written above the line, like drawIndicatorLines.
+    const int textOffset = i == 0 ? -16 : 0;
+    const float indicatorTextY =
+        y + height - (i * indicatorLineSpacing) + textOffset + rowOffset;
 
-    float previousPoleHeight;
-    if (i == 0) {
-      previousPoleHeight = currentPoleHeight;
+    uint16_t indicatorTextYConstrained = 0;
+    if (indicatorTextY > 0) {
+      indicatorTextYConstrained = indicatorTextY;
     }
 
-    //// Calculate Appropriate data line colors
-
-    if (previousPoleHeight ==
-        currentPoleHeight) // If no change in between current and previous
-                           // sample value.
-    {
-      BSP_LCD_SetTextColor(LCD_COLOR_YELLOW);
-    } else if (currentPoleHeight >
-               previousPoleHeight) // If current value is higher than previous.
-    {
-      BSP_LCD_SetTextColor(LCD_COLOR_GREEN);
-    } else // If current value is lower than previous.
-    {
-      BSP_LCD_SetTextColor(LCD_COLOR_RED);
+    const float indicatorValue = lowestValue + indicatorValueDelta * i;
+    display->displayStringAt(distanceFromRightEdge, indicatorTextYConstrained,
+                             numberToUInt8Array(indicatorValue), RIGHT_MODE);
+  }
+}
+
+/**
+ * @brief Draws several datasets in one diagram with shared grid lines.
+ * Every series is binned into pixel columns once, finding its extrema on the
+ * way, and the grid is only drawn once. Series sharing the left axis are
+ * scaled to their combined extrema. Series with their own axis are scaled to
+ * their own extrema and get their labels drawn on the right, in the color of
+ * the series.
+ *
+ * @param series The series which to draw. At most MAX_SERIES.
+ * @param seriesCount Amount of series.
+ * @param x x-axis offset of the diagram.
+ * @param y y-axis offset of the diagram.
+ * @param width Width of diagram.
+ * @param height Height of diagram.
+ * @param indicatorLines Amount of indicator lines the diagram should have.
+ */
+void drawMultiSeriesGraph(Series *series, int seriesCount, float x, float y,
+                          float width, float height, int indicatorLines) {
+  if (seriesCount > MAX_SERIES) {
+    seriesCount = MAX_SERIES;
+  }
+  if (seriesCount < 1) {
+    return;
+  }
+
+  //// Bin every series once, the columns are drawn after the grid.
+  float minimalSampleValues[MAX_SERIES];
+  float maximalSampleValues[MAX_SERIES];
+  int columnCounts[MAX_SERIES];
+  for (int s = 0; s < seriesCount; ++s) {
+    minimalSampleValues[s] = 0.0f;
+    maximalSampleValues[s] = 0.0f;
+    columnCounts[s] = 0;
+    if (!series[s].dataset->empty()) {
+      columnCounts[s] = binDatasetIntoColumns(
+          series[s].dataset, envelopeColumns[s], width,
+          &minimalSampleValues[s], &maximalSampleValues[s]);
     }
+  }
 
-    // Draw the graph point normalized.
-    const float poleWidth = width / datasetSize;
-    BSP_LCD_DrawLine(x + i * poleWidth, y + height - previousPoleHeight,
-                     x + (i + 1) * poleWidth, y + height - currentPoleHeight);
+  //// Combine the extrema of the series sharing the left axis.
+  bool hasSharedSeries = false;
+  int sharedAxisSeries = 0; // Series whose unit the left axis is labelled in.
+  float sharedMinimalValue = minimalSampleValues[0];
+  float sharedMaximalValue = maximalSampleValues[0];
+  for (int s = 0; s < seriesCount; ++s) {
+    if (series[s].hasOwnAxis || series[s].dataset->empty()) {
+      continue;
+    }
+    if (!hasSharedSeries) {
+      hasSharedSeries = true;
+      sharedAxisSeries = s;
+      sharedMinimalValue = minimalSampleValues[s];
+      sharedMaximalValue = maximalSampleValues[s];
+    } else {
+      sharedMinimalValue = kwin::min(sharedMinimalValue, minimalSampleValues[s]);
+      sharedMaximalValue = kwin::max(sharedMaximalValue, maximalSampleValues[s]);
+    }
+  }
+  // If no series shares the left axis, the first series is used for it.
+  const int leftAxisSeries = hasSharedSeries ? -1 : 0;
 
-    previousPoleHeight = currentPoleHeight;
+  //// Draw the grid and left axis once
+  display->setBackColor(LCD_COLOR_BLACK);
+  display->setTextColor(LCD_COLOR_WHITE);
+  // Samples are plotted as stored, only the labels are converted.
+  const kwin::LinearConversion<float> &sharedConversion =
+      series[sharedAxisSeries].displayConversion;
+  drawIndicatorLines(x, y, width, height,
+                     sharedConversion.apply(sharedMinimalValue),
+                     sharedConversion.apply(sharedMaximalValue),
+                     indicatorLines);
+
+  //// Draw the series
+  int rightAxisCount = 0;
+  for (int s = 0; s < seriesCount; ++s) {
+    float lowestValue = sharedMinimalValue;
+    float highestValue = sharedMaximalValue;
+    display->setTextColor(series[s].color);
+
+    if (series[s].hasOwnAxis) {
+      lowestValue = minimalSampleValues[s];
+      highestValue = maximalSampleValues[s];
+      if (s != leftAxisSeries && !series[s].dataset->empty()) {
+        const kwin::LinearConversion<float> &conversion =
+            series[s].displayConversion;
+        drawIndicatorLabels(x + width, y, height, conversion.apply(lowestValue),
+                            conversion.apply(highestValue), indicatorLines,
+                            rightAxisCount * 16);
+        ++rightAxisCount;
+      }
+    }
+
+    plotColumns(envelopeColumns[s], columnCounts[s], series[s].dataset->size(),
+                x, y, width, height, lowestValue, highestValue);
   }
 }
 
 /**
- * @brief Limit a dataset's size, cutting down to a specified amount of newest
- * sample entries.
+ * @brief Draws a line of statistics on the LCD in a small font.
+ *
+ * @param name Name of the measured quantity.
+ * @param statistics The statistics to draw.
+ * @param conversion Converts the statistics to the displayed unit.
+ * @param x x-axis offset of the line.
+ * @param y y-axis offset of the line.
+ */
+void drawStatisticsLine(const char *name,
+                        const kwin::StatisticsSnapshot &statistics,
+                        const kwin::LinearConversion<float> &conversion,
+                        float x, float y) {
+  char text[80];
+  snprintf(text, sizeof(text),
+           "%s avg %.2f sd %.2f ewma %.2f d %+.3f p50 %.2f p90 %.2f", name,
+           conversion.apply(statistics.mean),
+           conversion.applyToDifference(sqrtf(statistics.variance)),
+           conversion.apply(statistics.ewma),
+           conversion.applyToDifference(statistics.rateOfChange),
+           conversion.apply(statistics.median),
+           conversion.apply(statistics.percentile90));
+
+  sFONT *previousFont = display->getFont();
+  display->setFont(&Font12);
+  display->displayStringAt(x, y, (uint8_t *)text, LEFT_MODE);
+  display->setFont(previousFont);
+}
+
+/**
+ * @brief Draws a banner along the top of the LCD while alarms are raised.
  *
- * @param dataset The dataset to limit.
- * @param maxAmountOfSamples Amount of samples to limit the dataset to.
  */
-void limitDataSet(Dataset *dataset, int maxAmountOfSamples) {
-  if (dataset->size() > maxAmountOfSamples) {
-    const int samplesToDeleteCount = dataset->size() - maxAmountOfSamples;
-    dataset->erase(dataset->begin(), dataset->begin() + samplesToDeleteCount);
+void drawAlarmBanner() {
+  const AlarmBanner banner = alarmBanner.read();
+  if (banner.ruleIndex < 0) {
+    return;
   }
+
+  char text[64];
+  snprintf(text, sizeof(text), "ALARM: %s (%d active)", banner.ruleName,
+           banner.activeAlarmCount);
+
+  display->setTextColor(LCD_COLOR_RED);
+  display->fillRect(0, 0, SCREEN_WIDTH, 24);
+  display->setTextColor(LCD_COLOR_WHITE);
+  display->setBackColor(LCD_COLOR_RED);
+  display->displayStringAt(0, 0, (uint8_t *)text, CENTER_MODE);
+  display->setBackColor(LCD_COLOR_BLACK);
 }
 
 /**
@@ -283,7 +698,7 @@ void limitDataSet(Dataset *dataset, int maxAmountOfSamples) {
  *
  * @param dataset The dataset to print.
  */
-void printDataset(Dataset *dataset) {
+void printDataset(const Dataset *dataset) {
   printf("==============\n");
   const int datasetSize = dataset->size();
   for (int i = 0; i < datasetSize; ++i) {
@@ -292,44 +707,367 @@ void printDataset(Dataset *dataset) {
   printf("\n");
 }
 
+// The series of the graph, one per dataset.
+Series series[3];
+const int seriesCount = sizeof(series) / sizeof(series[0]);
+
+// Unit temperatures are displayed in.
+kwin::TemperatureUnit temperatureDisplayUnit = kwin::UNIT_CELSIUS;
+
 /**
- * @brief Starts the graph demostration.
+ * @brief Changes the unit temperatures are displayed in. The stored samples
+ * are left as they are, they are converted while drawing.
  *
- * @return int Exit code. Returns 1 if the program completed successfully.
+ * @param unit The unit to display temperatures in.
  */
+void setTemperatureDisplayUnit(kwin::TemperatureUnit unit) {
+  temperatureDisplayUnit = unit;
+  series[0].displayConversion =
+      temperatureDataset->getConversionTo(temperatureDisplayUnit);
+}
 
-int startGraphDemo() {
+/**
+ * @brief Handles commands from the serial line: 'c', 'f' and 'k' switch the
+ * displayed temperature unit. Runs every INPUT_INTERVAL_US.
+ *
+ */
+void handleSerialInput() {
+  while (serial.readable()) {
+    switch (serial.getc()) {
+    case 'c':
+      setTemperatureDisplayUnit(kwin::UNIT_CELSIUS);
+      break;
+    case 'f':
+      setTemperatureDisplayUnit(kwin::UNIT_FAHRENHEIT);
+      break;
+    case 'k':
+      setTemperatureDisplayUnit(kwin::UNIT_KELVIN);
+      break;
+    }
+  }
+}
 
-  initializeScreen();
+/**
+ * @brief Adds the latest sensor readings to the datasets. Runs on
+ * 'sampleEvent'.
+ *
+ */
+void handleSample() {
+  // Add the samples to the datasets.
+  temperatureDataset->push_back(temperature);
+  humidityDataset->push_back(humidity);
+  lightDataset->push_back(light);
+
+  // The datasets only keep the MAX_DATASET_SAMPLES most recent samples.
+  if (DEBUG_MODE_DATASET) { // If debug mode is activated.
+    // Print the dataset to the serial port.
+    printDataset(&temperatureDataset->getSamples());
+  }
+}
+
+/**
+ * @brief Draws a frame. Runs every FRAME_INTERVAL_US.
+ *
+ */
+void renderFrame() {
+  display = &retainedDisplay.beginFrame();
 
-  // Initialize new dataset.
-  Dataset *dataset;
-  dataset = new Dataset();
+  // Clear lcd background.
+  display->clear(LCD_COLOR_BLACK);
 
-  // Start the temperature sensor thread.
-  temporatureSensorThread.start(temperatureUpdateLoop);
+  // Draw all climate variables on the whole LCD screen.
+  drawMultiSeriesGraph(series, seriesCount, 0.0f, 0.0f, SCREEN_WIDTH - 1.0f,
+                       SCREEN_HEIGHT - 1.0f, INDICATOR_LINES);
 
-  while (1) {
+  // Draw the rolling statistics along the bottom of the screen.
+  char temperatureName[8];
+  snprintf(temperatureName, sizeof(temperatureName), "T(%s)",
+           kwin::getTemperatureUnitSymbol(temperatureDisplayUnit));
+  display->setTextColor(LCD_COLOR_ORANGE);
+  drawStatisticsLine(temperatureName, temperatureStatistics.read(),
+                     series[0].displayConversion, 4.0f, SCREEN_HEIGHT - 40.0f);
+  display->setTextColor(LCD_COLOR_YELLOW);
+  drawStatisticsLine("L", lightStatistics.read(), series[2].displayConversion,
+                     4.0f, SCREEN_HEIGHT - 28.0f);
 
-    // Add tempetature sample to 'dataset'.
-    dataset->push_back(temperature);
+  drawAlarmBanner();
 
-    // Purge all data samples except the 100 most recent.
-    limitDataSet(dataset, 100);
+  // Draw only what changed since the previous frame.
+  retainedDisplay.endFrame();
+}
+
+// Size of the flash region holding the history snapshots: the last two
+// 256 KB sectors of the STM32F746, one per bank of the snapshot store.
+const uint32_t SNAPSHOT_STORE_BYTES = 2 * 256 * 1024;
+// Interval between history snapshots. A bank holds 22 snapshots of 11.5 KB,
+// so each sector is erased every 440 minutes and its 10000 erase cycles last
+// about 8 years.
+const uint32_t SNAPSHOT_INTERVAL_US = 600000000;
+// Version of the GraphSnapshot layout. Change it whenever the layout changes.
+const uint32_t GRAPH_SNAPSHOT_VERSION = 3;
+
+/**
+ * @brief The history and settings persisted across resets.
+ *
+ */
+struct GraphSnapshot {
+  uint32_t version;                      // GRAPH_SNAPSHOT_VERSION.
+  uint32_t temperatureStorageUnit;       // Unit of the temperature samples.
+  uint32_t temperatureDisplayUnit;       // A kwin::TemperatureUnit.
+  uint32_t sampleCounts[3];              // Amount of samples per series.
+  float samples[3][MAX_DATASET_SAMPLES]; // Samples per series, oldest first.
+};
+
+kwin::FlashBlockStore snapshotFlash(SNAPSHOT_STORE_BYTES);
+kwin::SnapshotStore snapshotStore(snapshotFlash);
+GraphSnapshot graphSnapshot; // Staging buffer of saves and restores.
+// True while 'graphSnapshot' holds a snapshot waiting to be written. Set by
+// the event loop, cleared by the sensor thread.
+std::atomic<bool> snapshotPending(false);
+
+/**
+ * @brief Stages the history and settings for the sensor thread to save.
+ * Runs every SNAPSHOT_INTERVAL_US.
+ *
+ */
+void stageSnapshot() {
+  if (snapshotPending) {
+    return; // The previous snapshot wasn't written yet.
+  }
+
+  graphSnapshot.version = GRAPH_SNAPSHOT_VERSION;
+  graphSnapshot.temperatureStorageUnit = temperatureDataset->getUnit();
+  graphSnapshot.temperatureDisplayUnit = temperatureDisplayUnit;
+  for (int s = 0; s < seriesCount; ++s) {
+    int count = 0;
+    for (Dataset::const_iterator it = series[s].dataset->begin();
+         it != series[s].dataset->end(); ++it) {
+      graphSnapshot.samples[s][count++] = *it;
+    }
+    graphSnapshot.sampleCounts[s] = count;
+  }
+  snapshotPending = true;
+}
 
-    if (DEBUG_MODE_DATASET) { // If debug mode is activated.
-      // Print the dataset to the serial port.
-      printDataset(dataset);
+/**
+ * @brief Writes a staged snapshot, or else erases the snapshot store's spare
+ * bank if it needs it. Runs on the sensor thread right after a read.
+ *
+ * Programming and erasing the internal flash stall the CPU, as the program
+ * runs from the same single bank. A snapshot takes a few milliseconds, an
+ * erase one to four seconds, once every 22 snapshots. Running them right
+ * after a read keeps them out of the AM2302's edge timing.
+ */
+void writeSnapshotFlash() {
+  if (snapshotPending) {
+    if (!snapshotStore.save(&graphSnapshot, sizeof(graphSnapshot))) {
+      serial.printf("Saving the history snapshot failed\n");
     }
-    // Clear lcd background.
-    BSP_LCD_Clear(LCD_COLOR_BLACK);
+    snapshotPending = false;
+  } else if (snapshotStore.needsErase() && !snapshotStore.eraseSpareBank()) {
+    serial.printf("Erasing the snapshot bank failed\n");
+  }
+}
+
+/**
+ * @brief Restores the history and settings saved before the last reset, and
+ * replays the restored samples into the rolling statistics.
+ *
+ * @return bool True if a snapshot was restored.
+ */
+bool restoreSnapshot() {
+  uint32_t size = 0;
+  if (!snapshotStore.restore(&graphSnapshot, sizeof(graphSnapshot), &size) ||
+      size != sizeof(graphSnapshot) ||
+      graphSnapshot.version != GRAPH_SNAPSHOT_VERSION ||
+      graphSnapshot.temperatureStorageUnit > kwin::UNIT_KELVIN) {
+    return false;
+  }
+
+  int counts[3];
+  for (int s = 0; s < seriesCount; ++s) {
+    counts[s] =
+        kwin::min<int>(graphSnapshot.sampleCounts[s], MAX_DATASET_SAMPLES);
+  }
+
+  // Temperatures saved by a firmware storing another unit are converted.
+  temperatureDataset->append(
+      graphSnapshot.samples[0], counts[0],
+      (kwin::TemperatureUnit)graphSnapshot.temperatureStorageUnit);
+  for (int i = 0; i < counts[1]; ++i) {
+    humidityDataset->push_back(graphSnapshot.samples[1][i]);
+  }
+  for (int i = 0; i < counts[2]; ++i) {
+    lightDataset->push_back(graphSnapshot.samples[2][i]);
+  }
 
-    // Draw a graph on the whole LCD screen.
-    drawLineGraph(dataset, 0.0f, 0.0f, SCREEN_WIDTH - 1.0f,
-                  SCREEN_HEIGHT - 1.0f, 5.0f);
+  const Dataset &temperatures = temperatureDataset->getSamples();
+  for (Dataset::const_iterator it = temperatures.begin();
+       it != temperatures.end(); ++it) {
+    temperatureStatistics.add(*it);
+  }
+  for (Dataset::const_iterator it = lightDataset->begin();
+       it != lightDataset->end(); ++it) {
+    lightStatistics.add(*it);
+  }
 
-    wait_us(100000); // 100ms loop delay.
+  if (graphSnapshot.temperatureDisplayUnit <= kwin::UNIT_KELVIN) {
+    setTemperatureDisplayUnit(
+        (kwin::TemperatureUnit)graphSnapshot.temperatureDisplayUnit);
   }
+  return true;
+}
+
+// Static RAM cost of every subsystem, known at build time.
+const size_t STATIC_RAM_COMPONENTS = sizeof(componentArena);
+const size_t STATIC_RAM_GRAPH = sizeof(envelopeColumns) + sizeof(series);
+const size_t STATIC_RAM_DISPLAY = sizeof(retainedDisplay);
+const size_t STATIC_RAM_STATISTICS =
+    sizeof(temperatureStatistics) + sizeof(lightStatistics);
+const size_t STATIC_RAM_ALARMS =
+    sizeof(alarmEngine) + sizeof(alarmBanner);
+const size_t STATIC_RAM_EVENT_LOOP = sizeof(eventClock) + sizeof(eventLoop);
+const size_t STATIC_RAM_SNAPSHOT =
+    sizeof(snapshotFlash) + sizeof(snapshotStore) + sizeof(graphSnapshot) +
+    sizeof(snapshotPending);
+const size_t STATIC_RAM_TOTAL =
+    STATIC_RAM_COMPONENTS + STATIC_RAM_GRAPH + STATIC_RAM_DISPLAY +
+    STATIC_RAM_STATISTICS + STATIC_RAM_ALARMS + STATIC_RAM_EVENT_LOOP +
+    STATIC_RAM_SNAPSHOT;
+
+// The DISCO-F746NG has 320 KB of internal RAM; leave room for the stacks,
+// the RTOS and the heap.
+static_assert(STATIC_RAM_TOTAL <= 128 * 1024,
+              "The demo's static RAM exceeds its budget");
+
+/**
+ * @brief Prints the static RAM cost of every subsystem, the arena usage and,
+ * if heap statistics are enabled, the heap usage to the serial line.
+ *
+ */
+void printMemoryReport() {
+  serial.printf("Static RAM: components %u, graph %u, display %u, "
+                "statistics %u, alarms %u, event loop %u, snapshot %u, "
+                "total %u bytes\n",
+                (unsigned)STATIC_RAM_COMPONENTS, (unsigned)STATIC_RAM_GRAPH,
+                (unsigned)STATIC_RAM_DISPLAY, (unsigned)STATIC_RAM_STATISTICS,
+                (unsigned)STATIC_RAM_ALARMS, (unsigned)STATIC_RAM_EVENT_LOOP,
+                (unsigned)STATIC_RAM_SNAPSHOT, (unsigned)STATIC_RAM_TOTAL);
+
+  serial.printf("Framebuffer (SDRAM): %u bytes, %s\n",
+                (unsigned)(SCREEN_WIDTH * SCREEN_HEIGHT *
+                           (KWIN_LCD_RGB565 ? 2 : 4)),
+                KWIN_LCD_RGB565 ? "RGB565" : "ARGB8888");
+
+  const kwin::AllocatorStatistics arena = componentArena.getStatistics();
+  serial.printf("Arena: %u/%u bytes used, high water %u, %u failed\n",
+                (unsigned)arena.used, (unsigned)arena.capacity,
+                (unsigned)arena.highWaterMark,
+                (unsigned)arena.failedAllocations);
+
+#if defined(MBED_HEAP_STATS_ENABLED) && MBED_HEAP_STATS_ENABLED
+  mbed_stats_heap_t heap;
+  mbed_stats_heap_get(&heap);
+  serial.printf("Heap: %lu bytes used, high water %lu, %lu failed\n",
+                (unsigned long)heap.current_size,
+                (unsigned long)heap.max_size,
+                (unsigned long)heap.alloc_fail_cnt);
+#endif
+}
+
+/**
+ * @brief Prints the CPU utilization of the event loop to the serial line and
+ * starts a new accounting window. Runs every REPORT_INTERVAL_US.
+ *
+ */
+void reportUtilization() {
+  const int taskCount = eventLoop.getTaskCount();
+  for (int i = 0; i < taskCount; ++i) {
+    const kwin::TaskStatistics statistics = eventLoop.getTaskStatistics(i);
+    serial.printf("%s: %.2f%% (%lu runs) ", statistics.name,
+                  statistics.utilization, (unsigned long)statistics.runCount);
+  }
+  serial.printf("idle: %.2f%%\n", eventLoop.getIdlePercentage());
+  eventLoop.resetAccounting();
+
+  printMemoryReport();
+}
+
+// Boot steps the main thread and the sensor thread wait on each other for.
+const uint32_t BOOT_HISTORY_RESTORED = 1 << 0;
+const uint32_t BOOT_SCREEN_READY = 1 << 1;
+rtos::EventFlags bootFlags;
+// True if the history was restored at boot. Set by the sensor thread before
+// BOOT_HISTORY_RESTORED.
+bool historyRestored = false;
+
+/**
+ * @brief Runs the sensor thread. Restores the history and sets up the alarms
+ * while the main thread initializes the LCD, then reads the sensors forever.
+ *
+ */
+void runSensorThread() {
+  // Restore the history before the sensor reads add to the statistics.
+  historyRestored = restoreSnapshot();
+  initializeAlarms();
+  bootFlags.set(BOOT_HISTORY_RESTORED);
+
+  // The LCD initialization configures GPIO ports the sensor pins share with
+  // read-modify-writes, which must not run concurrently with a read.
+  bootFlags.wait_any(BOOT_SCREEN_READY);
+  temperatureUpdateLoop();
+}
+
+/**
+ * @brief Starts the graph demostration.
+ *
+ * @return int Exit code. Returns 1 if the program completed successfully.
+ */
+
+int startGraphDemo() {
+
+  // Create the sensors and datasets in static memory.
+  temperatureSensor = componentArena.create<TemperatureSensor>(D4);
+  temperatureSensor->setCalibration(TEMPERATURE_CALIBRATION,
+                                    HUMIDITY_CALIBRATION);
+  lightSensor = componentArena.create<LightSensor>();
+  // Temperatures are stored in the unit they are measured in.
+  temperatureDataset =
+      componentArena.create<TemperatureDataset>(kwin::UNIT_CELSIUS);
+  humidityDataset = componentArena.create<Dataset>();
+  lightDataset = componentArena.create<Dataset>();
+
+  // The temperature shares the left axis, the others get their own axis.
+  const kwin::LinearConversion<float> unconverted =
+      kwin::LinearConversion<float>::identity();
+  series[0] = {&temperatureDataset->getSamples(), LCD_COLOR_ORANGE, false,
+               unconverted};
+  series[1] = {humidityDataset, LCD_COLOR_CYAN, true, unconverted};
+  series[2] = {lightDataset, LCD_COLOR_YELLOW, true, unconverted};
+  setTemperatureDisplayUnit(temperatureDisplayUnit);
+
+  // Register the tasks of the event loop.
+  sampleEvent = eventLoop.addEvent("sample", handleSample);
+  eventLoop.addTimer("frame", FRAME_INTERVAL_US, renderFrame);
+  eventLoop.addTimer("report", REPORT_INTERVAL_US, reportUtilization);
+  eventLoop.addTimer("input", INPUT_INTERVAL_US, handleSerialInput);
+  eventLoop.addTimer("snapshot", SNAPSHOT_INTERVAL_US, stageSnapshot);
+
+  // Restore the history on the sensor thread while the LCD initializes.
+  temporatureSensorThread.start(runSensorThread);
+  initializeScreen();
+  bootFlags.set(BOOT_SCREEN_READY);
+  bootFlags.wait_any(BOOT_HISTORY_RESTORED);
+
+  // Draw the first frame straight away, showing the restored history.
+  renderFrame();
+  serial.printf("First frame %lu us after boot, history %s\n",
+                (unsigned long)eventClock.nowUs(),
+                historyRestored ? "restored" : "empty");
+  printMemoryReport();
+
+  // Handle events forever, sleeping in between.
+  eventLoop.run();
 
   return 1;
 }
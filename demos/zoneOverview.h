@@ -0,0 +1,316 @@
+#include <atomic>
+#include <stdio.h>
+
+#include "mbed.h"
+#include "stm32746g_discovery_lcd.h"
+
+#include "kwin/graphics/displayList.h"
+#include "kwin/graphics/lcdLayer.h"
+#include "kwin/graphics/sparkline.h"
+#include "kwin/sensors/dhtReader.h"
+#include "kwin/utils/eventLoop.h"
+#include "kwin/utils/memoryPool.h"
+#include "kwin/utils/ringBuffer.h"
+#include "kwin/utils/statistics.h"
+
+/**
+ * @brief A climate zone: one AM2302 on its own data pin.
+ *
+ */
+struct ZoneConfig {
+  const char *name; // Shown on the overview.
+  PinName pin;      // Data pin of the zone's sensor.
+};
+
+// Most zones the overview has memory for and lays out.
+const int MAX_ZONES = 16;
+
+// The zones. Every sensor pin needs its own EXTI line, and the STM32 has one
+// line per pin number shared by all ports. The Arduino header has pins on
+// twelve line numbers, but line 1 is only on D13, PI1, which drives the LD1
+// LED, so the header fits eleven zones. More zones need pins with unused
+// numbers on other headers.
+const ZoneConfig ZONES[] = {
+    {"Z1", D4},   // PG7
+    {"Z2", D1},   // PC6
+    {"Z3", D3},   // PB4
+    {"Z4", D5},   // PI0
+    {"Z5", D7},   // PI3
+    {"Z6", D8},   // PI2
+    {"Z7", D9},   // PA15
+    {"Z8", D10},  // PA8
+    {"Z9", D12},  // PB14
+    {"Z10", D14}, // PB9
+    {"Z11", A1},  // PF10
+};
+const int ZONE_COUNT = sizeof(ZONES) / sizeof(ZONES[0]);
+static_assert(ZONE_COUNT <= MAX_ZONES, "Too many zones for the overview");
+
+// Interval between two readings of the same zone. The AM2302 needs at least
+// 2 seconds.
+const uint32_t ZONE_SAMPLE_INTERVAL_US = 4000000;
+// Interval between frames.
+const uint32_t ZONE_FRAME_INTERVAL_US = 250000;
+// Interval between CPU utilization reports on the serial line.
+const uint32_t ZONE_REPORT_INTERVAL_US = 10000000;
+
+// Samples of history per zone, 6.4 minutes at ZONE_SAMPLE_INTERVAL_US.
+const int ZONE_HISTORY_SAMPLES = 96;
+// Points a sparkline is drawn with at most. Keeps the lines of all zones
+// within the capacity of the display list.
+const int SPARKLINE_POINTS = 24;
+
+typedef kwin::RingBuffer<float, ZONE_HISTORY_SAMPLES> ZoneHistory;
+
+/**
+ * @brief The readings of a zone.
+ *
+ */
+struct Zone {
+  kwin::DhtReader *sensor;  // Reads the zone's sensor.
+  ZoneHistory temperatures; // Temperature history, in Celsius.
+  float humidity;           // Latest relative humidity.
+  // Statistics over the history, scales the zone's sparkline.
+  kwin::SlidingWindowStatistics<ZONE_HISTORY_SAMPLES> temperatureStatistics;
+  uint32_t failedReads; // Reads that timed out or failed their checksum.
+};
+
+Serial zoneSerial(USBTX, USBRX);
+
+// Static memory of the sensors.
+kwin::Arena<kwin::arenaBytesFor<kwin::DhtReader>(MAX_ZONES)> zoneSensorArena;
+Zone zones[MAX_ZONES];
+const ZoneConfig *zoneConfigs; // Configuration of the zones.
+int zoneCount = 0;             // Amount of zones.
+
+// Interval between the reads of two consecutive zones. Reads are staggered
+// evenly over the sample interval, so only one sensor drives its interrupt
+// at a time and the decoding load stays flat.
+uint32_t zoneReadIntervalUs;
+
+// Zones with a finished read, set from interrupt context.
+std::atomic<uint32_t> completedZones(0);
+
+#if defined(__MBED__)
+kwin::MbedClock zoneClock;
+#else
+// Host builds, e.g. the zone benchmark, bring their own clock.
+extern kwin::EventClock &zoneClock;
+#endif
+kwin::EventLoop<4> zoneEventLoop(zoneClock);
+int zoneSampleEvent; // Posted when a zone's read finished.
+
+int nextZone = 0;             // Zone read next.
+uint32_t nextZoneReadUs;      // Time the next read is scheduled for.
+uint32_t maxZoneReadJitterUs; // Latest start of a read since the last report.
+
+// Frames are recorded into 'zoneDisplay', and only the changes are drawn.
+kwin::RetainedDisplay zoneDisplay;
+
+// Static RAM of the demo, known at build time. The clock is left out, it's
+// a few words and not part of the demo on the host.
+const size_t ZONE_STATIC_RAM = sizeof(zones) + sizeof(zoneSensorArena) +
+                               sizeof(zoneEventLoop) + sizeof(zoneDisplay);
+
+// The same budget as the graph demo, leaving the rest of the 320 KB of
+// internal RAM to the stacks, the RTOS and the heap.
+static_assert(ZONE_STATIC_RAM <= 128 * 1024,
+              "The zone demo's static RAM exceeds its budget");
+
+/**
+ * @brief Starts the read of the next zone. Runs every zoneReadIntervalUs.
+ *
+ */
+void readNextZone() {
+  // Track how late the read starts, a frame or report can delay it.
+  const uint32_t nowUs = zoneClock.nowUs();
+  const int32_t lateUs = nowUs - nextZoneReadUs;
+  if (lateUs > 0 && (uint32_t)lateUs > maxZoneReadJitterUs) {
+    maxZoneReadJitterUs = lateUs;
+  }
+  nextZoneReadUs += zoneReadIntervalUs;
+  if ((int32_t)(nowUs - nextZoneReadUs) >= 0) {
+    // Reads were skipped, like the event loop does.
+    nextZoneReadUs = nowUs + zoneReadIntervalUs;
+  }
+
+  if (!zones[nextZone].sensor->startRead()) {
+    ++zones[nextZone].failedReads;
+  }
+  nextZone = (nextZone + 1) % zoneCount;
+}
+
+/**
+ * @brief Adds the readings of the finished zones to their histories. Runs on
+ * 'zoneSampleEvent'.
+ *
+ */
+void handleZoneSamples() {
+  const uint32_t completed = completedZones.exchange(0);
+  for (int z = 0; z < zoneCount; ++z) {
+    if (!(completed & (1u << z))) {
+      continue;
+    }
+
+    Zone &zone = zones[z];
+    if (zone.sensor->getStatus() != kwin::DHT_COMPLETE) {
+      ++zone.failedReads;
+      continue;
+    }
+    const kwin::DhtMeasurement measurement = zone.sensor->getMeasurement();
+    zone.temperatures.push_back(measurement.temperature);
+    zone.temperatureStatistics.add(measurement.temperature);
+    zone.humidity = measurement.humidity;
+  }
+}
+
+/**
+ * @brief Draws a zone's tile: its latest readings and temperature sparkline.
+ *
+ * @param display The display list to record into.
+ * @param zone The zone to draw.
+ * @param name Name of the zone.
+ * @param x x-axis offset of the tile.
+ * @param y y-axis offset of the tile.
+ * @param width Width of the tile.
+ * @param height Height of the tile.
+ */
+void drawZoneTile(kwin::DisplayList &display, const Zone &zone,
+                  const char *name, int x, int y, int width, int height) {
+  char text[32];
+  if (zone.temperatures.empty()) {
+    snprintf(text, sizeof(text), "%s --", name);
+  } else {
+    snprintf(text, sizeof(text), "%s %.1fC %.0f%%", name,
+             zone.temperatures.back(), zone.humidity);
+  }
+  display.setTextColor(zone.failedReads > 0 ? LCD_COLOR_YELLOW
+                                            : LCD_COLOR_WHITE);
+  display.displayStringAt(x + 4, y + 4, (uint8_t *)text, LEFT_MODE);
+
+  // Scale to the window's extremes, known without a pass over the samples.
+  const kwin::StatisticsSnapshot statistics =
+      zone.temperatureStatistics.read();
+  display.setTextColor(LCD_COLOR_ORANGE);
+  kwin::drawSparkline(display, zone.temperatures, x + 4, y + 20, width - 8,
+                      height - 24, statistics.minimum, statistics.maximum,
+                      SPARKLINE_POINTS);
+}
+
+/**
+ * @brief Draws the overview of all zones in one frame. Runs every
+ * ZONE_FRAME_INTERVAL_US.
+ *
+ */
+void renderZoneOverview() {
+  kwin::DisplayList &display = zoneDisplay.beginFrame();
+  display.clear(LCD_COLOR_BLACK);
+  display.setBackColor(LCD_COLOR_BLACK);
+  display.setFont(&Font12);
+
+  // Lay the zones out in a grid of four columns.
+  const int columns = zoneCount < 4 ? zoneCount : 4;
+  const int rows = (zoneCount + columns - 1) / columns;
+  const int screenWidth = BSP_LCD_GetXSize();
+  const int screenHeight = BSP_LCD_GetYSize();
+  const int tileWidth = screenWidth / columns;
+  const int tileHeight = screenHeight / rows;
+
+  display.setTextColor(LCD_COLOR_DARKGRAY);
+  for (int column = 1; column < columns; ++column) {
+    display.drawVLine(column * tileWidth, 0, screenHeight);
+  }
+  for (int row = 1; row < rows; ++row) {
+    display.drawHLine(0, row * tileHeight, screenWidth);
+  }
+
+  for (int z = 0; z < zoneCount; ++z) {
+    drawZoneTile(display, zones[z], zoneConfigs[z].name,
+                 z % columns * tileWidth, z / columns * tileHeight, tileWidth,
+                 tileHeight);
+  }
+
+  // Draw only what changed since the previous frame.
+  zoneDisplay.endFrame();
+}
+
+/**
+ * @brief Prints the CPU utilization, the read jitter and the failed reads on
+ * the serial line. Runs every ZONE_REPORT_INTERVAL_US.
+ *
+ */
+void reportZones() {
+  const int taskCount = zoneEventLoop.getTaskCount();
+  for (int i = 0; i < taskCount; ++i) {
+    const kwin::TaskStatistics statistics = zoneEventLoop.getTaskStatistics(i);
+    zoneSerial.printf("%s: %.2f%% (%lu runs) ", statistics.name,
+                      statistics.utilization,
+                      (unsigned long)statistics.runCount);
+  }
+  zoneSerial.printf("idle: %.2f%%\n", zoneEventLoop.getIdlePercentage());
+  zoneEventLoop.resetAccounting();
+
+  zoneSerial.printf("Read jitter: max %lu us of %lu us slots\n",
+                    (unsigned long)maxZoneReadJitterUs,
+                    (unsigned long)zoneReadIntervalUs);
+  maxZoneReadJitterUs = 0;
+
+  for (int z = 0; z < zoneCount; ++z) {
+    if (zones[z].failedReads > 0) {
+      zoneSerial.printf("%s: %lu failed reads\n", zoneConfigs[z].name,
+                        (unsigned long)zones[z].failedReads);
+    }
+  }
+}
+
+/**
+ * @brief Creates the readers of the zones and registers the tasks of the
+ * event loop. Call once, before running the loop.
+ *
+ * @param configs The zones, read in this order.
+ * @param count Amount of zones, at most MAX_ZONES.
+ */
+void initializeZones(const ZoneConfig *configs, int count) {
+  zoneConfigs = configs;
+  zoneCount = count;
+  zoneReadIntervalUs = ZONE_SAMPLE_INTERVAL_US / count;
+
+  // Create a reader per zone, reporting finished reads to the event loop.
+  for (int z = 0; z < count; ++z) {
+    zones[z].sensor = zoneSensorArena.create<kwin::DhtReader>(
+        configs[z].pin, kwin::DHT_MODEL_DHT22);
+    zones[z].humidity = 0.0f;
+    zones[z].failedReads = 0;
+    zones[z].sensor->onComplete = [z]() {
+      completedZones.fetch_or(1u << z);
+      zoneEventLoop.post(zoneSampleEvent);
+    };
+  }
+
+  // Register the tasks of the event loop.
+  zoneSampleEvent = zoneEventLoop.addEvent("sample", handleZoneSamples);
+  zoneEventLoop.addTimer("read", zoneReadIntervalUs, readNextZone);
+  nextZoneReadUs = zoneClock.nowUs() + zoneReadIntervalUs;
+  zoneEventLoop.addTimer("frame", ZONE_FRAME_INTERVAL_US, renderZoneOverview);
+  zoneEventLoop.addTimer("report", ZONE_REPORT_INTERVAL_US, reportZones);
+}
+
+/**
+ * @brief Called to start the zone overview demo.
+ *
+ * @return int Exit code. Returns 1 if the program completed successfully.
+ */
+int startZoneDemo() {
+  initializeZones(ZONES, ZONE_COUNT);
+
+  kwin::initializeLcdLayer();
+  renderZoneOverview();
+  zoneSerial.printf("%d zones, a read every %lu us, static RAM %u bytes\n",
+                    zoneCount, (unsigned long)zoneReadIntervalUs,
+                    (unsigned)ZONE_STATIC_RAM);
+
+  // Handle events forever, sleeping in between.
+  zoneEventLoop.run();
+
+  return 1;
+}
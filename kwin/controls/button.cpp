@@ -3,6 +3,7 @@
  */
 
 #include "button.h"
+#include "../graphics/lcdLayer.h"
 
 kwin::Button::Button(int x, int y, int width, int height) {
   this->positionX = x;
@@ -10,6 +11,7 @@ kwin::Button::Button(int x, int y, int width, int height) {
   this->width = width;
   this->height = height;
   this->pressed = false;
+  this->notPressedEvoked = false;
   this->textColor = LCD_COLOR_BLACK;         // Default button text color.
   this->backgroundColor = LCD_COLOR_MAGENTA; // Default button color.
   this->text = NULL;                         // Default button text.
@@ -18,7 +20,9 @@ kwin::Button::Button(int x, int y, int width, int height) {
 void kwin::Button::update(int cursorX, int cursorY, int previousCursorX,
                           int previousCursorY, bool cursorIsPressed) {
   if (cursorIsPressed) {
-    handleTouch(cursorX, cursorY);
+    const bool cursorMoved =
+        cursorX != previousCursorX || cursorY != previousCursorY;
+    handleTouch(cursorX, cursorY, cursorMoved);
   } else {
     handleNoTouch(previousCursorX, previousCursorY);
   }
@@ -27,8 +31,8 @@ void kwin::Button::update(int cursorX, int cursorY, int previousCursorX,
 void kwin::Button::render() {
 
   // Draw button background.
-  BSP_LCD_SetTextColor(this->backgroundColor);
-  BSP_LCD_FillRect(positionX, positionY, width, height);
+  kwin::fillLayerRect(positionX, positionY, width, height,
+                      this->backgroundColor);
 
   // Calculate button text position.
   int textLength;
@@ -41,12 +45,35 @@ void kwin::Button::render() {
   uint16_t textPositionY = positionY + height / 2;
 
   // Draw button text.
-  BSP_LCD_SetTextColor(this->textColor);
-  BSP_LCD_SetBackColor(this->backgroundColor);
+  BSP_LCD_SetTextColor(kwin::toPixelColor(this->textColor));
+  BSP_LCD_SetBackColor(kwin::toPixelColor(this->backgroundColor));
   BSP_LCD_DisplayStringAt(textPositionX, textPositionY, (uint8_t *)text,
                           Text_AlignModeTypdef::LEFT_MODE);
 }
 
+void kwin::Button::render(kwin::DisplayList &displayList) {
+
+  // Record button background.
+  displayList.setTextColor(this->backgroundColor);
+  displayList.fillRect(positionX, positionY, width, height);
+
+  if (!text) { // Nothing more to record without text.
+    return;
+  }
+
+  // Calculate button text position.
+  int textWidth = strlen(text) * 12;
+
+  uint16_t textPositionX = positionX + (width - textWidth) / 2;
+  uint16_t textPositionY = positionY + height / 2;
+
+  // Record button text.
+  displayList.setTextColor(this->textColor);
+  displayList.setBackColor(this->backgroundColor);
+  displayList.displayStringAt(textPositionX, textPositionY, (uint8_t *)text,
+                              Text_AlignModeTypdef::LEFT_MODE);
+}
+
 /////////////////////////
 // Getters and Setters //
 /////////////////////////
@@ -85,13 +112,14 @@ char *kwin::Button::getText() { return this->text; }
 // Event Deciding Logic //
 //////////////////////////
 
-void kwin::Button::handleTouch(int cursorX, int cursorY) {
+void kwin::Button::handleTouch(int cursorX, int cursorY, bool cursorMoved) {
   if (kwin::pointIsWithinRectangle(cursorX, cursorY, positionX, positionY,
                                    width, height)) {
     if (!this->pressed) {
       this->pressed = true;
+      this->notPressedEvoked = false;
       this->evokeOnPressed();
-    } else {
+    } else if (!this->suppressSteadyStateEvents || cursorMoved) {
       this->evokeOnHeld();
     }
   }
@@ -102,36 +130,38 @@ void kwin::Button::handleNoTouch(int previousCursorX, int previousCursorY) {
       kwin::pointIsWithinRectangle(previousCursorX, previousCursorY, positionX,
                                    positionY, width, height)) {
     this->pressed = false;
+    this->notPressedEvoked = false;
     this->evokeOnReleased();
-  } else {
+  } else if (!this->suppressSteadyStateEvents || !this->notPressedEvoked) {
+    this->notPressedEvoked = true;
     this->evokeOnNotPressed();
   }
 }
 
 void kwin::Button::evokeOnPressed() {
   /* Only evoke the event if it is set */
-  if (this->onPressed != NULL) {
+  if (this->onPressed) {
     this->onPressed();
   }
 }
 
 void kwin::Button::evokeOnHeld() {
   /* Only evoke the event if it is set */
-  if (this->onHeld != NULL) {
+  if (this->onHeld) {
     this->onHeld();
   }
 }
 
 void kwin::Button::evokeOnReleased() {
   /* Only evoke the event if it is set */
-  if (this->onReleased != NULL) {
+  if (this->onReleased) {
     this->onReleased();
   }
 }
 
 void kwin::Button::evokeOnNotPressed() {
   /* Only evoke the event if it is set */
-  if (this->onNotPressed != NULL) {
+  if (this->onNotPressed) {
     this->onNotPressed();
   }
 }
\ No newline at end of file
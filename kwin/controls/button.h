@@ -5,6 +5,8 @@
 #ifndef KWIN_CONTROLS_BUTTON
 #define KWIN_CONTROLS_BUTTON
 
+#include "../graphics/displayList.h"
+#include "../utils/delegate.h"
 #include "../utils/v1.h"
 #include "mbed.h"
 #include "stm32746g_discovery_lcd.h"
@@ -17,7 +19,8 @@ namespace kwin {
  *   The Button class is an event driving component.
  *   Button has 4 different events. onPressed, onHeld, onReleased, onNotPressed.
  *   When the Button::update function is run ONE of the four events will be
- * evoked.
+ * evoked. onHeld and onNotPressed repeat on every update while the state
+ * persists, unless suppressSteadyStateEvents is set.
  */
 class Button {
 public:
@@ -33,20 +36,30 @@ public:
   int backgroundColor; // Background color of the button.
   char *text;          // The Buttons text
 
+  bool suppressSteadyStateEvents = false; // If true onHeld only fires when
+                                          // the cursor moved, and
+                                          // onNotPressed only fires once
+                                          // per release.
+
   /////////////////////
   // Event Listeners //
   /////////////////////
 
-  void (*onPressed)() = NULL; // Function pointer representing a listener for
-                              // button's the onPressed event.
+  // Listeners are delegates, so they can be plain functions, member
+  // functions or capturing lambdas, without allocating.
+  typedef kwin::Delegate<void()> Listener;
+
+  Listener onPressed; // Delegate representing a listener for button's the
+                      // onPressed event.
 
-  void (*onHeld)() = NULL; // Function pointer representing a listener for
-                           // button's the onHeld event.
+  Listener onHeld; // Delegate representing a listener for button's the onHeld
+                   // event.
 
-  void (*onReleased)() = NULL; // Function pointer representing a listener for
-                               // button's the onReleased event.
+  Listener onReleased; // Delegate representing a listener for button's the
+                       // onReleased event.
 
-  void (*onNotPressed)() = NULL; // Function pointer representing a listener for
+  Listener onNotPressed; // Delegate representing a listener for button's the
+                         // onNotPressed event.
 
   ////////////////////////
   // Public Constructor //
@@ -79,6 +92,13 @@ public:
   /* Method that renders the button when called. */
   void render();
 
+  /*
+   * @brief Method that records the button into a display list, to be drawn
+   * by a kwin::RetainedDisplay.
+   * @param displayList The display list to record into.
+   */
+  void render(kwin::DisplayList &displayList);
+
   /////////////////////////
   // Getters and Setters //
   /////////////////////////
@@ -120,6 +140,7 @@ private:
   ////////////////////
 
   bool pressed; // Flag for determining what button event to evoke.
+  bool notPressedEvoked; // Flag for suppressing repeated onNotPressed events.
 
   /////////////////////
   // Private Methods //
@@ -128,8 +149,9 @@ private:
   /* @brief Method responsible for handling when a button touch is detected
    * @param cursorX x-axis coordinate of the cursor.
    * @param cursorY y-axis coordinate of the cursor.
+   * @param cursorMoved Should be true if the cursor moved since last call.
    */
-  void handleTouch(int cursorX, int cursorY);
+  void handleTouch(int cursorX, int cursorY, bool cursorMoved);
 
   /* @brief Method responsible for handling when a button touch is not detected
    * @param previousCursorX x-axis coordinate of the cursor from previous update
@@ -0,0 +1,478 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#include "displayList.h"
+#include "lcdLayer.h"
+#include "../utils/v1.h"
+#include <string.h>
+
+//////////
+// Rect //
+//////////
+
+bool kwin::Rect::intersects(const Rect &other) const {
+  return !isEmpty() && !other.isEmpty() && x < other.x + other.width &&
+         other.x < x + width && y < other.y + other.height &&
+         other.y < y + height;
+}
+
+bool kwin::Rect::contains(const Rect &other) const {
+  return other.x >= x && other.y >= y &&
+         other.x + other.width <= x + width &&
+         other.y + other.height <= y + height;
+}
+
+kwin::Rect kwin::Rect::intersected(const Rect &other) const {
+  const int16_t left = kwin::max(x, other.x);
+  const int16_t top = kwin::max(y, other.y);
+  const int16_t right = kwin::min<int16_t>(x + width, other.x + other.width);
+  const int16_t bottom =
+      kwin::min<int16_t>(y + height, other.y + other.height);
+  Rect rect = {left, top, (int16_t)(right - left), (int16_t)(bottom - top)};
+  return rect;
+}
+
+kwin::Rect kwin::Rect::united(const Rect &other) const {
+  if (isEmpty()) {
+    return other;
+  }
+  if (other.isEmpty()) {
+    return *this;
+  }
+  const int16_t left = kwin::min(x, other.x);
+  const int16_t top = kwin::min(y, other.y);
+  const int16_t right = kwin::max<int16_t>(x + width, other.x + other.width);
+  const int16_t bottom =
+      kwin::max<int16_t>(y + height, other.y + other.height);
+  Rect rect = {left, top, (int16_t)(right - left), (int16_t)(bottom - top)};
+  return rect;
+}
+
+int32_t kwin::Rect::area() const {
+  return isEmpty() ? 0 : (int32_t)width * height;
+}
+
+/* @return Rect The whole screen. */
+static kwin::Rect screenRect() {
+  kwin::Rect rect = {0, 0, (int16_t)BSP_LCD_GetXSize(),
+                     (int16_t)BSP_LCD_GetYSize()};
+  return rect;
+}
+
+/* @return bool True if a command can be drawn clipped to any rectangle
+ * without changing the pixels within it. */
+static bool isClippable(const kwin::DrawCommand &command) {
+  switch (command.type) {
+  case kwin::DRAW_FILL_RECT:
+  case kwin::DRAW_HLINE:
+  case kwin::DRAW_VLINE:
+    return true;
+  case kwin::DRAW_LINE:
+    // Axis aligned lines cover exactly their bounds.
+    return command.x0 == command.x1 || command.y0 == command.y1;
+  default:
+    return false;
+  }
+}
+
+/* @brief Draws a command to the LCD, clipped to 'clip' if it's clippable.
+ * Unclippable commands are drawn completely. */
+static void drawCommand(const kwin::DisplayList &list,
+                        const kwin::DrawCommand &command,
+                        const kwin::Rect &clip) {
+  if (isClippable(command)) {
+    const kwin::Rect visible = command.bounds.intersected(clip);
+    kwin::fillLayerRect(visible.x, visible.y, visible.width, visible.height,
+                        command.color);
+    return;
+  }
+
+  // Commands are recorded in ARGB8888, whatever the layer's pixel format.
+  BSP_LCD_SetTextColor(kwin::toPixelColor(command.color));
+
+  switch (command.type) {
+  case kwin::DRAW_LINE:
+    BSP_LCD_DrawLine(command.x0, command.y0, command.x1, command.y1);
+    break;
+  case kwin::DRAW_TEXT:
+    BSP_LCD_SetBackColor(kwin::toPixelColor(command.backColor));
+    BSP_LCD_SetFont((sFONT *)command.resource);
+    BSP_LCD_DisplayStringAt(command.x0, command.y0,
+                            (uint8_t *)list.getText(command), LEFT_MODE);
+    break;
+  case kwin::DRAW_BITMAP:
+    BSP_LCD_DrawBitmap(command.x0, command.y0, (uint8_t *)command.resource);
+    break;
+  }
+}
+
+/////////////////
+// DisplayList //
+/////////////////
+
+kwin::DisplayList::DisplayList() { reset(); }
+
+void kwin::DisplayList::reset() {
+  this->commandCount = 0;
+  this->textLength = 0;
+  this->overflowed = false;
+  // Same defaults as BSP_LCD_LayerDefaultInit.
+  this->textColor = LCD_COLOR_BLACK;
+  this->backColor = LCD_COLOR_WHITE;
+  this->font = &Font24;
+}
+
+kwin::DrawCommand *kwin::DisplayList::append(DrawCommandType type,
+                                             const Rect &bounds) {
+  if (this->commandCount >= KWIN_DISPLAY_LIST_MAX_COMMANDS) {
+    flush();
+  }
+  DrawCommand *command = &this->commands[this->commandCount++];
+  command->type = type;
+  command->x0 = bounds.x;
+  command->y0 = bounds.y;
+  command->x1 = bounds.width;
+  command->y1 = bounds.height;
+  command->color = this->textColor;
+  command->backColor = 0;
+  command->resource = NULL;
+  command->version = 0;
+  command->textOffset = 0;
+  command->textLength = 0;
+  command->bounds = bounds;
+  command->hash = 0;
+  return command;
+}
+
+void kwin::DisplayList::flush() {
+  const Rect screen = screenRect();
+  for (int i = 0; i < this->commandCount; ++i) {
+    if (this->commands[i].bounds.intersects(screen)) {
+      drawCommand(*this, this->commands[i], screen);
+    }
+  }
+  this->commandCount = 0;
+  this->textLength = 0;
+  this->overflowed = true;
+}
+
+/* @return uint32_t 'hash' continued over 'size' bytes, FNV-1a. */
+static uint32_t updateHash(uint32_t hash, const void *data, uint32_t size) {
+  const uint8_t *bytes = (const uint8_t *)data;
+  for (uint32_t i = 0; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * 16777619u;
+  }
+  return hash;
+}
+
+void kwin::DisplayList::finish(DrawCommand *command) {
+  const int16_t geometry[4] = {command->x0, command->y0, command->x1,
+                               command->y1};
+  uint32_t hash = updateHash(2166136261u, &command->type, 1);
+  hash = updateHash(hash, geometry, sizeof(geometry));
+  hash = updateHash(hash, &command->color, sizeof(command->color));
+  hash = updateHash(hash, &command->resource, sizeof(command->resource));
+  hash = updateHash(hash, &command->version, sizeof(command->version));
+  if (command->type == DRAW_TEXT) {
+    hash = updateHash(hash, &command->backColor, sizeof(command->backColor));
+    hash = updateHash(hash, getText(*command), command->textLength);
+  }
+  command->hash = hash;
+}
+
+void kwin::DisplayList::clear(uint32_t color) {
+  const uint32_t previousColor = this->textColor;
+  this->textColor = color;
+  const Rect screen = screenRect();
+  fillRect(0, 0, screen.width, screen.height);
+  this->textColor = previousColor;
+}
+
+void kwin::DisplayList::fillRect(uint16_t x, uint16_t y, uint16_t width,
+                                 uint16_t height) {
+  Rect bounds = {(int16_t)x, (int16_t)y, (int16_t)width, (int16_t)height};
+  DrawCommand *command = append(DRAW_FILL_RECT, bounds);
+  finish(command);
+}
+
+void kwin::DisplayList::drawHLine(uint16_t x, uint16_t y, uint16_t length) {
+  Rect bounds = {(int16_t)x, (int16_t)y, (int16_t)length, 1};
+  DrawCommand *command = append(DRAW_HLINE, bounds);
+  finish(command);
+}
+
+void kwin::DisplayList::drawVLine(uint16_t x, uint16_t y, uint16_t length) {
+  Rect bounds = {(int16_t)x, (int16_t)y, 1, (int16_t)length};
+  DrawCommand *command = append(DRAW_VLINE, bounds);
+  finish(command);
+}
+
+void kwin::DisplayList::drawLine(uint16_t x1, uint16_t y1, uint16_t x2,
+                                 uint16_t y2) {
+  // BSP_LCD_DrawLine draws both end points.
+  Rect bounds = {(int16_t)kwin::min(x1, x2), (int16_t)kwin::min(y1, y2),
+                 (int16_t)(kwin::max(x1, x2) - kwin::min(x1, x2) + 1),
+                 (int16_t)(kwin::max(y1, y2) - kwin::min(y1, y2) + 1)};
+  DrawCommand *command = append(DRAW_LINE, bounds);
+  command->x0 = x1;
+  command->y0 = y1;
+  command->x1 = x2;
+  command->y1 = y2;
+  finish(command);
+}
+
+void kwin::DisplayList::displayStringAt(uint16_t x, uint16_t y,
+                                        const uint8_t *text,
+                                        Text_AlignModeTypdef mode) {
+  const int32_t size = strlen((const char *)text);
+  const int32_t fontWidth = this->font->Width;
+  const int32_t screenWidth = BSP_LCD_GetXSize();
+  const int32_t charactersPerLine = screenWidth / fontWidth;
+
+  // Resolve the alignment the same way BSP_LCD_DisplayStringAt does.
+  int32_t column;
+  switch (mode) {
+  case CENTER_MODE:
+    column = x + ((charactersPerLine - size) * fontWidth) / 2;
+    break;
+  case RIGHT_MODE:
+    column = -x + ((charactersPerLine - size) * fontWidth);
+    break;
+  default:
+    column = x;
+    break;
+  }
+  if (column < 1 || column >= 0x8000) {
+    column = 1;
+  }
+
+  // BSP_LCD_DisplayStringAt stops after a screen width of characters.
+  const int32_t drawnCharacters = kwin::min(size, charactersPerLine);
+
+  if (this->textLength + size + 1 > KWIN_DISPLAY_LIST_MAX_TEXT_BYTES) {
+    flush();
+  }
+  if (size + 1 > KWIN_DISPLAY_LIST_MAX_TEXT_BYTES) {
+    // Longer than the whole buffer, drawn right away.
+    BSP_LCD_SetTextColor(kwin::toPixelColor(this->textColor));
+    BSP_LCD_SetBackColor(kwin::toPixelColor(this->backColor));
+    BSP_LCD_SetFont(this->font);
+    BSP_LCD_DisplayStringAt(column, y, (uint8_t *)text, LEFT_MODE);
+    return;
+  }
+
+  Rect bounds = {(int16_t)column, (int16_t)y,
+                 (int16_t)(drawnCharacters * fontWidth),
+                 (int16_t)this->font->Height};
+  DrawCommand *command = append(DRAW_TEXT, bounds);
+  command->backColor = this->backColor;
+  command->resource = this->font;
+  command->textOffset = this->textLength;
+  command->textLength = size;
+  memcpy(this->text + this->textLength, text, size + 1);
+  this->textLength += size + 1;
+  finish(command);
+}
+
+void kwin::DisplayList::drawBitmap(uint16_t x, uint16_t y, uint8_t *bitmap,
+                                   uint32_t version) {
+  // Dimensions from the BMP header, little endian.
+  const int32_t width = bitmap[18] | (bitmap[19] << 8) | (bitmap[20] << 16) |
+                        (bitmap[21] << 24);
+  const int32_t height = bitmap[22] | (bitmap[23] << 8) |
+                         (bitmap[24] << 16) | (bitmap[25] << 24);
+  Rect bounds = {(int16_t)x, (int16_t)y, (int16_t)width, (int16_t)height};
+  DrawCommand *command = append(DRAW_BITMAP, bounds);
+  command->resource = bitmap;
+  command->version = version;
+  finish(command);
+}
+
+bool kwin::DisplayList::commandEquals(int index, const DisplayList &other,
+                                      int otherIndex) const {
+  const DrawCommand &a = this->commands[index];
+  const DrawCommand &b = other.commands[otherIndex];
+  if (a.hash != b.hash || a.type != b.type || a.x0 != b.x0 || a.y0 != b.y0 ||
+      a.x1 != b.x1 || a.y1 != b.y1 || a.color != b.color ||
+      a.resource != b.resource || a.version != b.version) {
+    return false;
+  }
+  if (a.type == DRAW_TEXT) {
+    return a.backColor == b.backColor && a.textLength == b.textLength &&
+           memcmp(getText(a), other.getText(b), a.textLength) == 0;
+  }
+  return true;
+}
+
+/////////////////////
+// RetainedDisplay //
+/////////////////////
+
+kwin::RetainedDisplay::RetainedDisplay() {
+  this->current = 0;
+  this->fullRedraw = true; // Nothing has been drawn yet.
+  this->dirtyRectCount = 0;
+  this->repaintedArea = 0;
+}
+
+kwin::DisplayList &kwin::RetainedDisplay::beginFrame() {
+  this->lists[this->current].reset();
+  return this->lists[this->current];
+}
+
+void kwin::RetainedDisplay::endFrame() {
+  const DisplayList &frame = this->lists[this->current];
+  const DisplayList &previous = this->lists[1 - this->current];
+  const Rect screen = screenRect();
+
+  //// Collect the regions that changed since the previous frame.
+  this->dirtyRectCount = 0;
+  if (this->fullRedraw || frame.hasOverflowed() || previous.hasOverflowed()) {
+    addDirtyRect(screen);
+    this->fullRedraw = false;
+  } else {
+    addChangedRegions(frame, previous);
+  }
+
+  //// Repaint the changed regions.
+  this->repaintedArea = 0;
+  for (int i = 0; i < this->dirtyRectCount; ++i) {
+    const Rect clip =
+        closeOverUnclippable(frame, this->dirtyRects[i]).intersected(screen);
+    if (!clip.isEmpty()) {
+      replay(frame, clip);
+      this->repaintedArea += clip.area();
+    }
+  }
+
+  this->current = 1 - this->current;
+}
+
+void kwin::RetainedDisplay::addChangedRegions(const DisplayList &frame,
+                                              const DisplayList &previous) {
+  const int frameCount = frame.getCommandCount();
+  const int previousCount = previous.getCommandCount();
+
+  // Skip the unchanged commands at the start and the end.
+  int start = 0;
+  while (start < frameCount && start < previousCount &&
+         frame.commandEquals(start, previous, start)) {
+    ++start;
+  }
+  int frameEnd = frameCount;
+  int previousEnd = previousCount;
+  while (frameEnd > start && previousEnd > start &&
+         frame.commandEquals(frameEnd - 1, previous, previousEnd - 1)) {
+    --frameEnd;
+    --previousEnd;
+  }
+
+  // Index the remaining commands of the previous frame by hash.
+  for (int i = 0; i < KWIN_DISPLAY_HASH_BUCKETS; ++i) {
+    this->hashBuckets[i] = -1;
+  }
+  for (int i = previousEnd - 1; i >= start; --i) {
+    int16_t &bucket = this->hashBuckets[previous.getCommand(i).hash &
+                                        (KWIN_DISPLAY_HASH_BUCKETS - 1)];
+    this->nextInBucket[i] = bucket;
+    bucket = i;
+  }
+
+  // Match the remaining commands in order. The matched commands are a common
+  // subsequence of both frames, so outside the regions of the unmatched ones
+  // both frames draw the same commands in the same order.
+  int previousNext = start; // First previous command not yet matched or
+                            // repainted.
+  for (int i = start; i < frameEnd; ++i) {
+    const DrawCommand &command = frame.getCommand(i);
+    int16_t &bucket =
+        this->hashBuckets[command.hash & (KWIN_DISPLAY_HASH_BUCKETS - 1)];
+    // Chains are ascending, drop the commands that were passed.
+    while (bucket >= 0 && bucket < previousNext) {
+      bucket = this->nextInBucket[bucket];
+    }
+
+    int match = bucket;
+    while (match >= 0 && match - previousNext < KWIN_DISPLAY_MATCH_WINDOW &&
+           !frame.commandEquals(i, previous, match)) {
+      match = this->nextInBucket[match];
+    }
+    if (match < 0 || match - previousNext >= KWIN_DISPLAY_MATCH_WINDOW) {
+      addDirtyRect(command.bounds); // New or changed.
+      continue;
+    }
+
+    // The previous commands skipped to get here were removed or changed.
+    for (; previousNext < match; ++previousNext) {
+      addDirtyRect(previous.getCommand(previousNext).bounds);
+    }
+    previousNext = match + 1;
+  }
+  for (; previousNext < previousEnd; ++previousNext) {
+    addDirtyRect(previous.getCommand(previousNext).bounds);
+  }
+}
+
+void kwin::RetainedDisplay::addDirtyRect(Rect rect) {
+  if (rect.isEmpty()) {
+    return;
+  }
+
+  // Merge with every region it overlaps.
+  for (int i = 0; i < this->dirtyRectCount;) {
+    if (this->dirtyRects[i].intersects(rect)) {
+      rect = rect.united(this->dirtyRects[i]);
+      this->dirtyRects[i] = this->dirtyRects[--this->dirtyRectCount];
+      i = 0; // The grown region may overlap regions checked before.
+    } else {
+      ++i;
+    }
+  }
+
+  if (this->dirtyRectCount < KWIN_DISPLAY_MAX_DIRTY_RECTS) {
+    this->dirtyRects[this->dirtyRectCount++] = rect;
+    return;
+  }
+
+  // Out of regions, merge with the one that grows the least.
+  int best = 0;
+  int32_t bestGrowth = 0x7FFFFFFF;
+  for (int i = 0; i < this->dirtyRectCount; ++i) {
+    const int32_t growth =
+        this->dirtyRects[i].united(rect).area() - this->dirtyRects[i].area();
+    if (growth < bestGrowth) {
+      best = i;
+      bestGrowth = growth;
+    }
+  }
+  this->dirtyRects[best] = this->dirtyRects[best].united(rect);
+}
+
+kwin::Rect kwin::RetainedDisplay::closeOverUnclippable(const DisplayList &list,
+                                                       Rect rect) {
+  const int count = list.getCommandCount();
+  bool grown = true;
+  while (grown) {
+    grown = false;
+    for (int i = 0; i < count; ++i) {
+      const DrawCommand &command = list.getCommand(i);
+      if (!isClippable(command) && command.bounds.intersects(rect) &&
+          !rect.contains(command.bounds)) {
+        rect = rect.united(command.bounds);
+        grown = true;
+      }
+    }
+  }
+  return rect;
+}
+
+void kwin::RetainedDisplay::replay(const DisplayList &list, const Rect &clip) {
+  const int count = list.getCommandCount();
+  for (int i = 0; i < count; ++i) {
+    const DrawCommand &command = list.getCommand(i);
+    if (command.bounds.intersects(clip)) {
+      drawCommand(list, command, clip);
+    }
+  }
+}
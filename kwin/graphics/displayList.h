@@ -0,0 +1,260 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#ifndef KWIN_GRAPHICS_DISPLAY_LIST
+#define KWIN_GRAPHICS_DISPLAY_LIST
+
+#include "stm32746g_discovery_lcd.h"
+#include <stdint.h>
+
+// Maximum amount of draw commands a display list can record per frame.
+#ifndef KWIN_DISPLAY_LIST_MAX_COMMANDS
+#define KWIN_DISPLAY_LIST_MAX_COMMANDS 512
+#endif
+
+// Maximum amount of text bytes a display list can record per frame.
+#ifndef KWIN_DISPLAY_LIST_MAX_TEXT_BYTES
+#define KWIN_DISPLAY_LIST_MAX_TEXT_BYTES 2048
+#endif
+
+// Maximum amount of separate regions redrawn per frame. More changed regions
+// are merged.
+#ifndef KWIN_DISPLAY_MAX_DIRTY_RECTS
+#define KWIN_DISPLAY_MAX_DIRTY_RECTS 8
+#endif
+
+// Amount of hash buckets the previous frame's commands are indexed by when
+// frames are compared. A power of two.
+#ifndef KWIN_DISPLAY_HASH_BUCKETS
+#define KWIN_DISPLAY_HASH_BUCKETS 256
+#endif
+
+// How far ahead in the previous frame a command is looked for. Commands
+// skipped to reach a match are repainted, so distant matches aren't worth it.
+#ifndef KWIN_DISPLAY_MATCH_WINDOW
+#define KWIN_DISPLAY_MATCH_WINDOW 64
+#endif
+
+namespace kwin {
+
+/*
+ * @brief Axis aligned rectangle in pixels.
+ */
+struct Rect {
+  int16_t x;      // x-axis position of the left edge.
+  int16_t y;      // y-axis position of the top edge.
+  int16_t width;  // Width, zero or less if the rectangle is empty.
+  int16_t height; // Height, zero or less if the rectangle is empty.
+
+  bool isEmpty() const { return width <= 0 || height <= 0; }
+
+  /* @return bool True if this and 'other' share at least one pixel. */
+  bool intersects(const Rect &other) const;
+
+  /* @return bool True if 'other' lies completely within this rectangle. */
+  bool contains(const Rect &other) const;
+
+  /* @return Rect The pixels shared by this and 'other'. */
+  Rect intersected(const Rect &other) const;
+
+  /* @return Rect The smallest rectangle containing this and 'other'. */
+  Rect united(const Rect &other) const;
+
+  /* @return int32_t The amount of pixels in the rectangle. */
+  int32_t area() const;
+};
+
+/* @brief Kinds of recorded draw commands. */
+enum DrawCommandType {
+  DRAW_FILL_RECT, // BSP_LCD_FillRect, also used for clearing.
+  DRAW_HLINE,     // BSP_LCD_DrawHLine.
+  DRAW_VLINE,     // BSP_LCD_DrawVLine.
+  DRAW_LINE,      // BSP_LCD_DrawLine.
+  DRAW_TEXT,      // BSP_LCD_DisplayStringAt.
+  DRAW_BITMAP     // BSP_LCD_DrawBitmap.
+};
+
+/*
+ * @brief One recorded draw call and the state it depends on.
+ */
+struct DrawCommand {
+  uint8_t type;         // A DrawCommandType.
+  int16_t x0;           // Position, or first line end point.
+  int16_t y0;           // Position, or first line end point.
+  int16_t x1;           // Second line end point, rectangle width or length.
+  int16_t y1;           // Second line end point or rectangle height.
+  uint32_t color;       // Text color at the time of recording.
+  uint32_t backColor;   // Back color, only used by text.
+  const void *resource; // Font of text, or the bitmap of a blit.
+  uint32_t version;     // Version of a bitmap.
+  uint16_t textOffset;  // Index of the text in its list's text buffer.
+  uint16_t textLength;  // Length of the text.
+  Rect bounds;          // Pixels the command may touch.
+  uint32_t hash;        // Hash of everything commandEquals compares.
+};
+
+/*
+ * @brief Recorded list of draw commands, mirroring the BSP_LCD drawing API.
+ *
+ *   #Funcional resume:
+ *   Widgets and charts record a frame into a DisplayList instead of drawing
+ *   immediately. Text is copied into the list, so callers may reuse their
+ *   buffers. Recording past the capacity draws the commands recorded so far
+ *   to the LCD immediately and continues with an empty list, marking it as
+ *   overflowed, so no command is lost. An overflowed frame is drawn
+ *   completely.
+ */
+class DisplayList {
+public:
+  DisplayList();
+
+  /* @brief Removes all commands and restores the default drawing state. */
+  void reset();
+
+  ///////////////////
+  // Drawing State //
+  ///////////////////
+
+  void setTextColor(uint32_t color) { this->textColor = color; }
+  uint32_t getTextColor() { return this->textColor; }
+
+  void setBackColor(uint32_t color) { this->backColor = color; }
+  uint32_t getBackColor() { return this->backColor; }
+
+  void setFont(sFONT *font) { this->font = font; }
+  sFONT *getFont() { return this->font; }
+
+  ///////////////////////
+  // Drawing Commands  //
+  ///////////////////////
+
+  /* @brief Records filling the whole screen with 'color'. */
+  void clear(uint32_t color);
+
+  void fillRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+  void drawHLine(uint16_t x, uint16_t y, uint16_t length);
+  void drawVLine(uint16_t x, uint16_t y, uint16_t length);
+  void drawLine(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2);
+
+  /*
+   * @brief Records drawing text. The alignment is resolved while recording,
+   * like BSP_LCD_DisplayStringAt does while drawing.
+   */
+  void displayStringAt(uint16_t x, uint16_t y, const uint8_t *text,
+                       Text_AlignModeTypdef mode);
+
+  /*
+   * @brief Records drawing a BMP image.
+   * @param bitmap The BMP image, which must stay valid.
+   * @param version Should change whenever the image contents change.
+   */
+  void drawBitmap(uint16_t x, uint16_t y, uint8_t *bitmap,
+                  uint32_t version = 0);
+
+  /////////////
+  // Getters //
+  /////////////
+
+  int getCommandCount() const { return this->commandCount; }
+  const DrawCommand &getCommand(int index) const {
+    return this->commands[index];
+  }
+
+  /* @return const char* The text of a DRAW_TEXT command. */
+  const char *getText(const DrawCommand &command) const {
+    return this->text + command.textOffset;
+  }
+
+  /* @return bool True if commands were drawn immediately for lack of
+   * capacity. The list only holds the commands recorded since. */
+  bool hasOverflowed() const { return this->overflowed; }
+
+  /*
+   * @return bool True if command 'index' of this list draws exactly the same
+   * as command 'otherIndex' of 'other'.
+   */
+  bool commandEquals(int index, const DisplayList &other,
+                     int otherIndex) const;
+
+private:
+  DrawCommand commands[KWIN_DISPLAY_LIST_MAX_COMMANDS]; // The commands.
+  char text[KWIN_DISPLAY_LIST_MAX_TEXT_BYTES];          // Text of commands.
+  int commandCount;   // Amount of commands.
+  int textLength;     // Used bytes of 'text'.
+  bool overflowed;    // True if commands were drawn immediately.
+  uint32_t textColor; // Current text color.
+  uint32_t backColor; // Current back color.
+  sFONT *font;        // Current font.
+
+  /* @return DrawCommand* A new command with the current color. Flushes the
+   * list first if it's full. */
+  DrawCommand *append(DrawCommandType type, const Rect &bounds);
+
+  /* @brief Hashes a completely recorded command. */
+  void finish(DrawCommand *command);
+
+  /* @brief Draws the recorded commands to the LCD and removes them, to make
+   * room for more. */
+  void flush();
+};
+
+/*
+ * @brief Draws frames recorded into display lists, replaying only what
+ * changed since the previous frame.
+ *
+ *   #Funcional resume:
+ *   Every frame is recorded into the list returned by beginFrame. endFrame
+ *   matches its commands with the previous frame's by content, in order, so
+ *   inserting or removing a command only changes its own region. The
+ *   regions of the commands left unmatched in either frame are collected,
+ *   and each region is grown until no text,
+ *   bitmap or diagonal line crosses its edge, and then the commands touching
+ *   it are replayed clipped to it. Frames should start with a clear, so every
+ *   region is repainted from the background up.
+ */
+class RetainedDisplay {
+public:
+  RetainedDisplay();
+
+  /* @return DisplayList& The list to record the next frame into. */
+  DisplayList &beginFrame();
+
+  /* @brief Draws the changes of the recorded frame to the LCD. */
+  void endFrame();
+
+  /* @brief Forces the next frame to be redrawn completely. */
+  void invalidate() { this->fullRedraw = true; }
+
+  /* @return int32_t Pixels repainted by the last frame. */
+  int32_t getLastRepaintedArea() const { return this->repaintedArea; }
+
+private:
+  DisplayList lists[2]; // The previous and the current frame.
+  int current;          // Index of the current frame's list.
+  bool fullRedraw;      // True if the next frame must be drawn completely.
+  Rect dirtyRects[KWIN_DISPLAY_MAX_DIRTY_RECTS]; // Regions to repaint.
+  int dirtyRectCount;                            // Amount of regions.
+  int32_t repaintedArea; // Pixels repainted by the last frame.
+
+  // Previous frame's commands by hash, chained in ascending order.
+  int16_t hashBuckets[KWIN_DISPLAY_HASH_BUCKETS];
+  int16_t nextInBucket[KWIN_DISPLAY_LIST_MAX_COMMANDS];
+
+  /* @brief Adds the regions of the commands that differ between frames. */
+  void addChangedRegions(const DisplayList &frame,
+                         const DisplayList &previous);
+
+  /* @brief Adds a region to repaint, merging it with overlapping ones. */
+  void addDirtyRect(Rect rect);
+
+  /* @brief Grows a region until it contains every unclippable command of
+   * 'list' it touches. */
+  Rect closeOverUnclippable(const DisplayList &list, Rect rect);
+
+  /* @brief Replays the commands of 'list' touching 'clip', clipped to it. */
+  void replay(const DisplayList &list, const Rect &clip);
+};
+}; // namespace kwin
+
+#endif
@@ -0,0 +1,77 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#ifndef KWIN_GRAPHICS_LCD_LAYER
+#define KWIN_GRAPHICS_LCD_LAYER
+
+#include "rgb565.h"
+#include "stm32746g_discovery_lcd.h"
+
+// Set to 1 to use a 16-bit RGB565 framebuffer instead of 32-bit ARGB8888,
+// halving its memory and bandwidth.
+#ifndef KWIN_LCD_RGB565
+#define KWIN_LCD_RGB565 0
+#endif
+
+// In RGB565 mode, fills of up to this many pixels use the CPU kernel. Larger
+// fills go to the DMA2D, whose register setup and completion polling cost
+// more than a few hundred pixel stores, but which then writes the SDRAM in
+// bursts without the CPU.
+#ifndef KWIN_LCD_CPU_FILL_MAX_PIXELS
+#define KWIN_LCD_CPU_FILL_MAX_PIXELS 512
+#endif
+
+namespace kwin {
+
+/*
+ * @brief Initializes the LCD and its active layer in the configured pixel
+ * format.
+ */
+inline void initializeLcdLayer() {
+  BSP_LCD_Init();
+#if KWIN_LCD_RGB565
+  BSP_LCD_LayerRgb565Init(LTDC_ACTIVE_LAYER, LCD_FB_START_ADDRESS);
+#else
+  BSP_LCD_LayerDefaultInit(LTDC_ACTIVE_LAYER, LCD_FB_START_ADDRESS);
+#endif
+  BSP_LCD_SelectLayer(LTDC_ACTIVE_LAYER);
+}
+
+/*
+ * @brief Converts an ARGB8888 color to the value BSP_LCD writes for single
+ * pixels (lines and text) in the configured pixel format. BSP_LCD stores
+ * those values as they are, while its fills convert from ARGB8888 themselves.
+ * @param color The ARGB8888 color.
+ * @return uint32_t The color for BSP_LCD_SetTextColor and BSP_LCD_SetBackColor.
+ */
+inline uint32_t toPixelColor(uint32_t color) {
+#if KWIN_LCD_RGB565
+  return rgb565::fromArgb8888(color);
+#else
+  return color;
+#endif
+}
+
+/*
+ * @brief Fills a rectangle of the active layer. In RGB565 mode small fills
+ * use the word-wide RGB565 kernel, everything else goes through
+ * BSP_LCD_FillRect and its DMA2D register-to-memory transfer.
+ * @param color The ARGB8888 color.
+ */
+inline void fillLayerRect(uint16_t x, uint16_t y, uint16_t width,
+                          uint16_t height, uint32_t color) {
+#if KWIN_LCD_RGB565
+  if ((uint32_t)width * height <= KWIN_LCD_CPU_FILL_MAX_PIXELS) {
+    rgb565::fillRect((uint16_t *)LCD_FB_START_ADDRESS, BSP_LCD_GetXSize(), x,
+                     y, width, height, rgb565::fromArgb8888(color));
+    return;
+  }
+#endif
+  // The DMA2D converts the ARGB8888 color to the layer's format.
+  BSP_LCD_SetTextColor(color);
+  BSP_LCD_FillRect(x, y, width, height);
+}
+} // namespace kwin
+
+#endif
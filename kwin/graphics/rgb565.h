@@ -0,0 +1,166 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#ifndef KWIN_GRAPHICS_RGB565
+#define KWIN_GRAPHICS_RGB565
+
+#include <stdint.h>
+#include <string.h>
+
+namespace kwin {
+namespace rgb565 {
+
+/*
+ * @brief Converts an ARGB8888 color to RGB565, dropping the alpha channel.
+ * @param color The ARGB8888 color, e.g. one of the LCD_COLOR_* values.
+ * @return uint16_t The RGB565 color.
+ */
+inline uint16_t fromArgb8888(uint32_t color) {
+  return ((color >> 8) & 0xF800) | ((color >> 5) & 0x07E0) |
+         ((color >> 3) & 0x001F);
+}
+
+/*
+ * @brief Converts an RGB565 color to opaque ARGB8888, replicating the high
+ * bits into the low bits so white stays white.
+ * @param color The RGB565 color.
+ * @return uint32_t The ARGB8888 color.
+ */
+inline uint32_t toArgb8888(uint16_t color) {
+  const uint32_t red = (color >> 11) & 0x1F;
+  const uint32_t green = (color >> 5) & 0x3F;
+  const uint32_t blue = color & 0x1F;
+  return 0xFF000000 | ((red << 3 | red >> 2) << 16) |
+         ((green << 2 | green >> 4) << 8) | (blue << 3 | blue >> 2);
+}
+
+/*
+ * @brief Fills 'count' consecutive pixels with 'color'.
+ * Writes two pixels per 32-bit store, eight per iteration, after aligning
+ * the destination to a word. On a host the GCC vector extension is used, so
+ * the compiler can emit SIMD stores.
+ * @param destination First pixel to fill.
+ * @param count Amount of pixels to fill.
+ * @param color The RGB565 color.
+ */
+inline void fillSpan(uint16_t *destination, uint32_t count, uint16_t color) {
+  // Align to a word.
+  if (count > 0 && ((uintptr_t)destination & 2)) {
+    *destination++ = color;
+    --count;
+  }
+
+  const uint32_t pair = color | ((uint32_t)color << 16);
+  uint32_t *words = (uint32_t *)destination;
+
+#if defined(__GNUC__) && !defined(__arm__)
+  // Portable vector code for host builds: eight pixels per store.
+  typedef uint32_t Vector __attribute__((vector_size(16), aligned(4)));
+  const Vector pairs = {pair, pair, pair, pair};
+  for (; count >= 8; count -= 8, words += 4) {
+    *(Vector *)words = pairs;
+  }
+#else
+  // Four word stores per iteration, which the Cortex-M7 pairs into STRDs.
+  for (; count >= 8; count -= 8, words += 4) {
+    words[0] = pair;
+    words[1] = pair;
+    words[2] = pair;
+    words[3] = pair;
+  }
+#endif
+  for (; count >= 2; count -= 2) {
+    *words++ = pair;
+  }
+
+  if (count > 0) {
+    *(uint16_t *)words = color;
+  }
+}
+
+/*
+ * @brief Fills a horizontal line of pixels.
+ * @param framebuffer First pixel of the framebuffer.
+ * @param stride Pixels per framebuffer row.
+ * @param x x-axis position of the line's first pixel.
+ * @param y y-axis position of the line.
+ * @param length Length of the line in pixels.
+ * @param color The RGB565 color.
+ */
+inline void hline(uint16_t *framebuffer, uint32_t stride, uint32_t x,
+                  uint32_t y, uint32_t length, uint16_t color) {
+  fillSpan(framebuffer + y * stride + x, length, color);
+}
+
+/*
+ * @brief Fills a rectangle of pixels.
+ * @param framebuffer First pixel of the framebuffer.
+ * @param stride Pixels per framebuffer row.
+ * @param x x-axis position of the rectangle.
+ * @param y y-axis position of the rectangle.
+ * @param width Width of the rectangle.
+ * @param height Height of the rectangle.
+ * @param color The RGB565 color.
+ */
+inline void fillRect(uint16_t *framebuffer, uint32_t stride, uint32_t x,
+                     uint32_t y, uint32_t width, uint32_t height,
+                     uint16_t color) {
+  uint16_t *row = framebuffer + y * stride + x;
+  for (uint32_t i = 0; i < height; ++i, row += stride) {
+    fillSpan(row, width, color);
+  }
+}
+
+/*
+ * @brief Copies a rectangle of RGB565 pixels into the framebuffer.
+ * Rows whose source and destination share their word alignment are copied a
+ * word (two pixels) at a time.
+ * @param framebuffer First pixel of the framebuffer.
+ * @param stride Pixels per framebuffer row.
+ * @param x x-axis position to copy to.
+ * @param y y-axis position to copy to.
+ * @param source First pixel of the image.
+ * @param sourceStride Pixels per image row.
+ * @param width Width of the rectangle.
+ * @param height Height of the rectangle.
+ */
+inline void blitRect(uint16_t *framebuffer, uint32_t stride, uint32_t x,
+                     uint32_t y, const uint16_t *source,
+                     uint32_t sourceStride, uint32_t width, uint32_t height) {
+  uint16_t *row = framebuffer + y * stride + x;
+  for (uint32_t i = 0; i < height; ++i, row += stride, source += sourceStride) {
+    uint16_t *to = row;
+    const uint16_t *from = source;
+    uint32_t count = width;
+
+    if ((((uintptr_t)to ^ (uintptr_t)from) & 2) != 0) {
+      // Different alignment, words can't be used.
+      memcpy(to, from, count * sizeof(uint16_t));
+      continue;
+    }
+
+    if (count > 0 && ((uintptr_t)to & 2)) {
+      *to++ = *from++;
+      --count;
+    }
+    uint32_t *toWords = (uint32_t *)to;
+    const uint32_t *fromWords = (const uint32_t *)from;
+    for (; count >= 8; count -= 8, toWords += 4, fromWords += 4) {
+      toWords[0] = fromWords[0];
+      toWords[1] = fromWords[1];
+      toWords[2] = fromWords[2];
+      toWords[3] = fromWords[3];
+    }
+    for (; count >= 2; count -= 2) {
+      *toWords++ = *fromWords++;
+    }
+    if (count > 0) {
+      *(uint16_t *)toWords = *(const uint16_t *)fromWords;
+    }
+  }
+}
+} // namespace rgb565
+} // namespace kwin
+
+#endif
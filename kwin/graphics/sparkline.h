@@ -0,0 +1,83 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#ifndef KWIN_GRAPHICS_SPARKLINE
+#define KWIN_GRAPHICS_SPARKLINE
+
+#include "displayList.h"
+
+namespace kwin {
+
+/*
+ * @brief Records a sparkline, a small line graph without axes, in one pass
+ * over the samples. Consecutive samples are averaged into at most
+ * 'maxPoints' points, which bounds the amount of recorded commands.
+ * @param list The display list to record into, using its text color.
+ * @param samples The samples, a container with size, begin and end, e.g. a
+ * RingBuffer.
+ * @param x x-axis position of the sparkline.
+ * @param y y-axis position of the sparkline.
+ * @param width Width of the sparkline.
+ * @param height Height of the sparkline.
+ * @param lowestValue Value drawn at the bottom.
+ * @param highestValue Value drawn at the top.
+ * @param maxPoints Maximum amount of points, at least 2.
+ */
+template <typename Samples>
+void drawSparkline(DisplayList &list, const Samples &samples, int x, int y,
+                   int width, int height, float lowestValue,
+                   float highestValue, int maxPoints) {
+  const int sampleCount = samples.size();
+  if (sampleCount < 2 || width < 2 || height < 1) {
+    return;
+  }
+
+  const int samplesPerPoint = (sampleCount + maxPoints - 1) / maxPoints;
+  const int pointCount = (sampleCount + samplesPerPoint - 1) / samplesPerPoint;
+  if (pointCount < 2) {
+    return;
+  }
+
+  const float range = highestValue - lowestValue;
+  const float pixelsPerValue = range > 0.0f ? (height - 1) / range : 0.0f;
+  const float pixelsPerPoint = (float)(width - 1) / (pointCount - 1);
+  const int bottom = y + height - 1;
+
+  int point = 0;
+  int binCount = 0;
+  float binSum = 0.0f;
+  int previousX = 0;
+  int previousY = 0;
+  int remaining = sampleCount;
+  for (typename Samples::const_iterator it = samples.begin();
+       it != samples.end(); ++it) {
+    binSum += *it;
+    ++binCount;
+    --remaining;
+    if (binCount < samplesPerPoint && remaining > 0) {
+      continue;
+    }
+
+    const float mean = binSum / binCount;
+    const int pointX = x + (int)(point * pixelsPerPoint + 0.5f);
+    int pointY = bottom - (int)((mean - lowestValue) * pixelsPerValue + 0.5f);
+    if (pointY < y) {
+      pointY = y;
+    } else if (pointY > bottom) {
+      pointY = bottom;
+    }
+
+    if (point > 0) {
+      list.drawLine(previousX, previousY, pointX, pointY);
+    }
+    previousX = pointX;
+    previousY = pointY;
+    ++point;
+    binSum = 0.0f;
+    binCount = 0;
+  }
+}
+} // namespace kwin
+
+#endif
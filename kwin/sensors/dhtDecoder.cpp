@@ -0,0 +1,148 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#include "dhtDecoder.h"
+#include <string.h>
+
+// Accepted pulse widths in microseconds. The datasheets give 80 us for the
+// response pulses, 50 us for bit lows, and 26-28 us or 70 us for bit highs.
+static const uint32_t RESPONSE_MIN_US = 30;
+static const uint32_t RESPONSE_MAX_US = 150;
+static const uint32_t BIT_LOW_MIN_US = 20;
+static const uint32_t BIT_LOW_MAX_US = 120;
+static const uint32_t BIT_HIGH_MIN_US = 10;
+static const uint32_t BIT_HIGH_MAX_US = 120;
+// High pulses longer than this are 1 bits.
+static const uint32_t BIT_ONE_THRESHOLD_US = 48;
+
+static bool isWithin(uint32_t value, uint32_t minimum, uint32_t maximum) {
+  return value >= minimum && value <= maximum;
+}
+
+kwin::DhtDecoder::DhtDecoder(DhtModel model) : model(model) {
+  reset();
+  this->status = DHT_IDLE;
+}
+
+void kwin::DhtDecoder::reset() {
+  this->state = WAIT_FOR_RESPONSE;
+  this->status = DHT_DECODING;
+  this->lastEdgeUs = 0;
+  this->bitCount = 0;
+  memset(this->bytes, 0, sizeof(this->bytes));
+  this->measurement.temperature = 0.0f;
+  this->measurement.humidity = 0.0f;
+}
+
+kwin::DhtStatus kwin::DhtDecoder::feedEdge(bool rising, uint32_t timeUs) {
+  const uint32_t pulseUs = timeUs - this->lastEdgeUs;
+
+  switch (this->state) {
+  case WAIT_FOR_RESPONSE:
+    if (!rising) {
+      this->state = RESPONSE_LOW;
+    }
+    break;
+
+  case RESPONSE_LOW:
+    if (!rising || !isWithin(pulseUs, RESPONSE_MIN_US, RESPONSE_MAX_US)) {
+      return fail(DHT_ERROR_TIMING);
+    }
+    this->state = RESPONSE_HIGH;
+    break;
+
+  case RESPONSE_HIGH:
+    if (rising || !isWithin(pulseUs, RESPONSE_MIN_US, RESPONSE_MAX_US)) {
+      return fail(DHT_ERROR_TIMING);
+    }
+    this->state = BIT_LOW;
+    break;
+
+  case BIT_LOW:
+    if (!rising || !isWithin(pulseUs, BIT_LOW_MIN_US, BIT_LOW_MAX_US)) {
+      return fail(DHT_ERROR_TIMING);
+    }
+    this->state = BIT_HIGH;
+    break;
+
+  case BIT_HIGH:
+    if (rising || !isWithin(pulseUs, BIT_HIGH_MIN_US, BIT_HIGH_MAX_US)) {
+      return fail(DHT_ERROR_TIMING);
+    }
+    // Bits are sent most significant first.
+    this->bytes[this->bitCount / 8] <<= 1;
+    if (pulseUs > BIT_ONE_THRESHOLD_US) {
+      this->bytes[this->bitCount / 8] |= 1;
+    }
+    ++this->bitCount;
+    if (this->bitCount == 40) {
+      return complete();
+    }
+    this->state = BIT_LOW;
+    break;
+
+  case DONE:
+    // Edges after the frame, e.g. the line being released, are ignored.
+    return this->status;
+  }
+
+  this->lastEdgeUs = timeUs;
+  return this->status;
+}
+
+kwin::DhtStatus kwin::DhtDecoder::finish() {
+  if (this->state != DONE) {
+    return fail(DHT_ERROR_TIMEOUT);
+  }
+  return this->status;
+}
+
+kwin::DhtStatus kwin::DhtDecoder::decode(const DhtEdge *edges, int edgeCount,
+                                         DhtModel model,
+                                         DhtMeasurement *measurement) {
+  DhtDecoder decoder(model);
+  decoder.reset();
+  for (int i = 0; i < edgeCount; ++i) {
+    if (decoder.feedEdge(edges[i].rising, edges[i].timeUs) != DHT_DECODING) {
+      break;
+    }
+  }
+  const DhtStatus status = decoder.finish();
+  if (status == DHT_COMPLETE) {
+    *measurement = decoder.getMeasurement();
+  }
+  return status;
+}
+
+kwin::DhtStatus kwin::DhtDecoder::fail(DhtStatus result) {
+  this->state = DONE;
+  this->status = result;
+  return result;
+}
+
+kwin::DhtStatus kwin::DhtDecoder::complete() {
+  const uint8_t *b = this->bytes;
+  if ((uint8_t)(b[0] + b[1] + b[2] + b[3]) != b[4]) {
+    return fail(DHT_ERROR_CHECKSUM);
+  }
+
+  if (this->model == DHT_MODEL_DHT11) {
+    this->measurement.humidity = b[0] + b[1] * 0.1f;
+    this->measurement.temperature = b[2] + (b[3] & 0x7F) * 0.1f;
+    if (b[3] & 0x80) {
+      this->measurement.temperature = -this->measurement.temperature;
+    }
+  } else {
+    // Tenths, the temperature in sign and magnitude.
+    this->measurement.humidity = ((b[0] << 8) | b[1]) * 0.1f;
+    this->measurement.temperature = (((b[2] & 0x7F) << 8) | b[3]) * 0.1f;
+    if (b[2] & 0x80) {
+      this->measurement.temperature = -this->measurement.temperature;
+    }
+  }
+
+  this->state = DONE;
+  this->status = DHT_COMPLETE;
+  return this->status;
+}
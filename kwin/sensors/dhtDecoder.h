@@ -0,0 +1,126 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#ifndef KWIN_SENSORS_DHT_DECODER
+#define KWIN_SENSORS_DHT_DECODER
+
+#include <stdint.h>
+
+namespace kwin {
+
+/* @brief Sensor models, which differ in how they encode their readings. */
+enum DhtModel {
+  DHT_MODEL_DHT11, // Whole degrees and percentages.
+  DHT_MODEL_DHT22  // Tenths of degrees and percentages, also the AM2302.
+};
+
+/* @brief State of a read. */
+enum DhtStatus {
+  DHT_IDLE,           // No read was started.
+  DHT_DECODING,       // Edges are still expected.
+  DHT_COMPLETE,       // A measurement was decoded.
+  DHT_ERROR_TIMING,   // A pulse was too short, too long or missing.
+  DHT_ERROR_CHECKSUM, // All bits arrived, but the checksum didn't match.
+  DHT_ERROR_TIMEOUT   // The sensor stopped sending before the last bit.
+};
+
+/* @brief A level change of the data line. */
+struct DhtEdge {
+  uint32_t timeUs; // Microsecond timestamp of the edge.
+  bool rising;     // True if the line went high.
+};
+
+/* @brief A decoded measurement. */
+struct DhtMeasurement {
+  float temperature; // Degrees celsius.
+  float humidity;    // Relative humidity in percent.
+};
+
+/*
+ * @brief Decodes the single-wire protocol of DHT11, DHT22 and AM2302 sensors
+ * from edge timestamps.
+ *
+ *   #Funcional resume:
+ *   After the start pulse the sensor answers with an 80 us low and an 80 us
+ *   high pulse, followed by 40 bits. Every bit is a 50 us low pulse followed
+ *   by a high pulse, 26-28 us for a 0 and 70 us for a 1. The decoder is fed
+ *   the edges one at a time and measures the pulses between them. It is pure
+ *   and hardware independent, so it can run on recorded edge traces.
+ */
+class DhtDecoder {
+public:
+  // Edges from the start of the response to the end of the last bit.
+  static const int FRAME_EDGE_COUNT = 83;
+
+  explicit DhtDecoder(DhtModel model = DHT_MODEL_DHT22);
+
+  /* @brief Prepares for the edges of a new read. */
+  void reset();
+
+  /*
+   * @brief Feeds the next edge of the data line. Rising edges before the
+   * response are ignored, they're the line being released.
+   * @param rising True if the line went high.
+   * @param timeUs Microsecond timestamp of the edge. May wrap around.
+   * @return DhtStatus DHT_DECODING while more edges are expected.
+   */
+  DhtStatus feedEdge(bool rising, uint32_t timeUs);
+
+  /*
+   * @brief Ends a read, e.g. when its deadline passed.
+   * @return DhtStatus DHT_ERROR_TIMEOUT if the read was still decoding.
+   */
+  DhtStatus finish();
+
+  /////////////
+  // Getters //
+  /////////////
+
+  DhtStatus getStatus() const { return this->status; }
+
+  /* @return const DhtMeasurement& The measurement, valid once complete. */
+  const DhtMeasurement &getMeasurement() const { return this->measurement; }
+
+  /* @return const uint8_t* The five received bytes, the last one being the
+   * checksum. */
+  const uint8_t *getBytes() const { return this->bytes; }
+
+  /*
+   * @brief Decodes a recorded read.
+   * @param edges The edges of the read.
+   * @param edgeCount Amount of edges.
+   * @param model Model of the sensor.
+   * @param measurement Output for the measurement if the read is complete.
+   * @return DhtStatus The status after the last edge.
+   */
+  static DhtStatus decode(const DhtEdge *edges, int edgeCount, DhtModel model,
+                          DhtMeasurement *measurement);
+
+private:
+  enum State {
+    WAIT_FOR_RESPONSE, // Waiting for the line to be pulled low.
+    RESPONSE_LOW,      // Inside the 80 us low response pulse.
+    RESPONSE_HIGH,     // Inside the 80 us high response pulse.
+    BIT_LOW,           // Inside the low pulse starting a bit.
+    BIT_HIGH,          // Inside the high pulse encoding a bit.
+    DONE               // Finished or failed.
+  };
+
+  DhtModel model;             // Model of the sensor.
+  State state;                // Position within the frame.
+  DhtStatus status;           // Result of the read.
+  uint32_t lastEdgeUs;        // Timestamp of the previous edge.
+  int bitCount;               // Amount of received bits.
+  uint8_t bytes[5];           // The received bytes.
+  DhtMeasurement measurement; // The decoded measurement.
+
+  /* @brief Ends the read with 'result'. */
+  DhtStatus fail(DhtStatus result);
+
+  /* @brief Validates the checksum and converts the received bytes. */
+  DhtStatus complete();
+};
+} // namespace kwin
+
+#endif
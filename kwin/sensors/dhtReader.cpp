@@ -0,0 +1,92 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#include "dhtReader.h"
+#include "us_ticker_api.h"
+
+// Length of the start pulse. The DHT11 needs at least 18 ms, the DHT22 and
+// AM2302 at least 1 ms.
+static const uint32_t DHT11_START_PULSE_US = 18000;
+static const uint32_t DHT22_START_PULSE_US = 1100;
+
+// Time from releasing the line until the frame must be complete. A frame
+// takes at most 160 us of response and 40 times 120 us of bits.
+static const uint32_t READ_DEADLINE_US = 6000;
+
+kwin::DhtReader::DhtReader(PinName pin, DhtModel model)
+    : model(model), line(pin), edgeInterrupt(pin), edgeCount(0),
+      capturing(false), busy(false), hasRead(false), lastStartUs(0),
+      status(DHT_IDLE) {
+  this->measurement.temperature = 0.0f;
+  this->measurement.humidity = 0.0f;
+
+  this->line.input();
+  this->edgeInterrupt.rise(callback(this, &DhtReader::handleRise));
+  this->edgeInterrupt.fall(callback(this, &DhtReader::handleFall));
+}
+
+bool kwin::DhtReader::startRead() {
+  if (this->busy) {
+    return false;
+  }
+  this->busy = true;
+  this->status = DHT_DECODING;
+  this->hasRead = true;
+  this->lastStartUs = us_ticker_read();
+
+  // Pull the line low, the Timeout releases it.
+  this->line.output();
+  this->line.write(0);
+  const uint32_t startPulseUs = this->model == DHT_MODEL_DHT11
+                                    ? DHT11_START_PULSE_US
+                                    : DHT22_START_PULSE_US;
+  this->timeout.attach_us(callback(this, &DhtReader::releaseLine),
+                          startPulseUs);
+  return true;
+}
+
+uint32_t kwin::DhtReader::getTimeUntilReadyUs() const {
+  if (!this->hasRead) {
+    return 0;
+  }
+  const uint32_t elapsedUs = us_ticker_read() - this->lastStartUs;
+  if (elapsedUs >= MINIMUM_INTERVAL_US) {
+    return 0;
+  }
+  return MINIMUM_INTERVAL_US - elapsedUs;
+}
+
+void kwin::DhtReader::releaseLine() {
+  this->edgeCount = 0;
+  this->capturing = true;
+  this->line.input();
+  this->timeout.attach_us(callback(this, &DhtReader::finishRead),
+                          READ_DEADLINE_US);
+}
+
+void kwin::DhtReader::recordEdge(bool rising) {
+  if (!this->capturing || this->edgeCount >= MAX_EDGES) {
+    return;
+  }
+  DhtEdge &edge = this->edges[this->edgeCount];
+  edge.timeUs = us_ticker_read();
+  edge.rising = rising;
+  ++this->edgeCount;
+}
+
+void kwin::DhtReader::finishRead() {
+  this->capturing = false;
+
+  DhtMeasurement decoded;
+  this->status =
+      DhtDecoder::decode(this->edges, this->edgeCount, this->model, &decoded);
+  if (this->status == DHT_COMPLETE) {
+    this->measurement = decoded;
+  }
+
+  this->busy = false;
+  if (this->onComplete) {
+    this->onComplete();
+  }
+}
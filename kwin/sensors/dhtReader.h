@@ -0,0 +1,105 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#ifndef KWIN_SENSORS_DHT_READER
+#define KWIN_SENSORS_DHT_READER
+
+#include "../utils/delegate.h"
+#include "dhtDecoder.h"
+#include "mbed.h"
+
+namespace kwin {
+
+/*
+ * @brief Reads a DHT11, DHT22 or AM2302 sensor without blocking.
+ *
+ *   #Funcional resume:
+ *   startRead pulls the data line low and returns. A Timeout releases the
+ *   line after the start pulse, and edge interrupts record the timestamp of
+ *   every level change of the sensor's answer into a buffer. When the read's
+ *   deadline passes, the edges are decoded by a DhtDecoder and onComplete is
+ *   called. No thread waits during a read, so several sensors can be read at
+ *   the same time.
+ */
+class DhtReader {
+public:
+  // Edges buffered per read: the frame, the line being released and the
+  // sensor releasing the line after the frame.
+  static const int MAX_EDGES = DhtDecoder::FRAME_EDGE_COUNT + 2;
+
+  // Minimum time between the starts of two reads, set by the sensors.
+  static const uint32_t MINIMUM_INTERVAL_US = 2000000;
+
+  /////////////////////
+  // Event Listeners //
+  /////////////////////
+
+  typedef kwin::Delegate<void()> Listener;
+
+  Listener onComplete; // Called from interrupt context when a read finished,
+                       // successfully or not. Keep it short, e.g. set an
+                       // event flag or post an event.
+
+  /*
+   * @param pin The data pin of the sensor, which needs a pull-up.
+   * @param model Model of the sensor.
+   */
+  DhtReader(PinName pin, DhtModel model = DHT_MODEL_DHT22);
+
+  /*
+   * @brief Starts a read and returns immediately.
+   * @return bool False if a read is already in progress.
+   */
+  bool startRead();
+
+  /////////////
+  // Getters //
+  /////////////
+
+  /* @return bool True while a read is in progress. */
+  bool isBusy() const { return this->busy; }
+
+  /* @return DhtStatus Result of the last read. */
+  DhtStatus getStatus() const { return this->status; }
+
+  /* @return DhtMeasurement The last successfully read measurement. */
+  DhtMeasurement getMeasurement() const { return this->measurement; }
+
+  /* @return uint32_t Microseconds until the sensor accepts another read. */
+  uint32_t getTimeUntilReadyUs() const;
+
+  /* @return int Amount of edges recorded by the last read. */
+  int getEdgeCount() const { return this->edgeCount; }
+
+  /* @return const DhtEdge& Edge 'index' of the last read, for debugging. */
+  const DhtEdge &getEdge(int index) const { return this->edges[index]; }
+
+private:
+  DhtModel model;             // Model of the sensor.
+  DigitalInOut line;          // The data line, driven for the start pulse.
+  InterruptIn edgeInterrupt;  // Interrupts on the data line's edges.
+  Timeout timeout;            // Ends the start pulse, then the read.
+  DhtEdge edges[MAX_EDGES];   // Edges of the current read.
+  volatile int edgeCount;     // Amount of recorded edges.
+  volatile bool capturing;    // True while edges are recorded.
+  volatile bool busy;         // True while a read is in progress.
+  bool hasRead;               // True once a read was started.
+  uint32_t lastStartUs;       // Timestamp of the last read's start.
+  DhtStatus status;           // Result of the last read.
+  DhtMeasurement measurement; // Last successfully read measurement.
+
+  /* @brief Ends the start pulse and starts recording edges. */
+  void releaseLine();
+
+  /* @brief Records an edge. Runs in interrupt context. */
+  void recordEdge(bool rising);
+  void handleRise() { recordEdge(true); }
+  void handleFall() { recordEdge(false); }
+
+  /* @brief Decodes the recorded edges and reports the result. */
+  void finishRead();
+};
+} // namespace kwin
+
+#endif
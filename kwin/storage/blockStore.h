@@ -0,0 +1,204 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#ifndef KWIN_STORAGE_BLOCK_STORE
+#define KWIN_STORAGE_BLOCK_STORE
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__MBED__)
+#include "mbed.h"
+#endif
+
+namespace kwin {
+
+/*
+ * @brief Storage with the semantics of NOR flash: a region must be erased
+ * before it's programmed, and erasing works on whole erase units.
+ */
+class BlockStore {
+public:
+  virtual ~BlockStore() {}
+
+  /* @return bool True if the store is usable. */
+  virtual bool init() = 0;
+
+  virtual bool read(uint32_t offset, void *buffer, uint32_t size) = 0;
+
+  /* @brief Programs an erased region. 'offset' and 'size' must be multiples
+   * of the program size. */
+  virtual bool program(uint32_t offset, const void *buffer, uint32_t size) = 0;
+
+  /* @brief Erases a region. 'offset' and 'size' must be multiples of the
+   * erase size. */
+  virtual bool erase(uint32_t offset, uint32_t size) = 0;
+
+  /* @return uint32_t Size of the store in bytes. */
+  virtual uint32_t getSize() = 0;
+
+  /* @return uint32_t Smallest amount of bytes that can be erased. */
+  virtual uint32_t getEraseSize() = 0;
+
+  /* @return uint32_t Smallest amount of bytes that can be programmed. */
+  virtual uint32_t getProgramSize() = 0;
+
+  /* @return uint8_t Value of every byte of an erased region. */
+  virtual uint8_t getEraseValue() = 0;
+};
+
+/*
+ * @brief Block store kept in a file, standing in for flash on a host.
+ * Programming only clears bits, like flash does, so programming a region
+ * that wasn't erased corrupts it the same way it would on the board.
+ */
+class FileBlockStore : public BlockStore {
+public:
+  /*
+   * @param path Path of the file, created erased if it doesn't exist.
+   * @param size Size of the store in bytes.
+   * @param eraseSize Size of an erase unit.
+   */
+  FileBlockStore(const char *path, uint32_t size, uint32_t eraseSize)
+      : path(path), file(NULL), size(size), eraseSize(eraseSize) {}
+
+  ~FileBlockStore() {
+    if (file != NULL) {
+      fclose(file);
+    }
+  }
+
+  bool init() {
+    file = fopen(path, "r+b");
+    if (file == NULL) {
+      file = fopen(path, "w+b");
+      if (file == NULL) {
+        return false;
+      }
+      return erase(0, size);
+    }
+    return true;
+  }
+
+  bool read(uint32_t offset, void *buffer, uint32_t count) {
+    if (file == NULL || offset + count > size) {
+      return false;
+    }
+    fseek(file, offset, SEEK_SET);
+    // Past the end of a short file reads as erased.
+    const size_t readCount = fread(buffer, 1, count, file);
+    memset((uint8_t *)buffer + readCount, ERASE_VALUE, count - readCount);
+    return true;
+  }
+
+  bool program(uint32_t offset, const void *buffer, uint32_t count) {
+    uint8_t chunk[64];
+    const uint8_t *bytes = (const uint8_t *)buffer;
+    while (count > 0) {
+      const uint32_t chunkSize = count < sizeof(chunk) ? count : sizeof(chunk);
+      if (!read(offset, chunk, chunkSize)) {
+        return false;
+      }
+      for (uint32_t i = 0; i < chunkSize; ++i) {
+        chunk[i] &= bytes[i];
+      }
+      fseek(file, offset, SEEK_SET);
+      if (fwrite(chunk, 1, chunkSize, file) != chunkSize) {
+        return false;
+      }
+      offset += chunkSize;
+      bytes += chunkSize;
+      count -= chunkSize;
+    }
+    return fflush(file) == 0;
+  }
+
+  bool erase(uint32_t offset, uint32_t count) {
+    if (file == NULL || offset % eraseSize != 0 || count % eraseSize != 0 ||
+        offset + count > size) {
+      return false;
+    }
+    uint8_t chunk[64];
+    memset(chunk, ERASE_VALUE, sizeof(chunk));
+    fseek(file, offset, SEEK_SET);
+    while (count > 0) {
+      const uint32_t chunkSize = count < sizeof(chunk) ? count : sizeof(chunk);
+      if (fwrite(chunk, 1, chunkSize, file) != chunkSize) {
+        return false;
+      }
+      count -= chunkSize;
+    }
+    return fflush(file) == 0;
+  }
+
+  uint32_t getSize() { return size; }
+  uint32_t getEraseSize() { return eraseSize; }
+  uint32_t getProgramSize() { return 1; }
+  uint8_t getEraseValue() { return ERASE_VALUE; }
+
+private:
+  static const uint8_t ERASE_VALUE = 0xFF;
+
+  const char *path;   // Path of the file.
+  FILE *file;         // The open file, NULL before init.
+  uint32_t size;      // Size of the store in bytes.
+  uint32_t eraseSize; // Size of an erase unit.
+};
+
+#if defined(__MBED__)
+/*
+ * @brief Block store in the last sectors of the MCU's internal flash.
+ * Erasing stalls the CPU, as code runs from the same flash bank; on the
+ * STM32F746 a 256 KB sector takes one to two seconds.
+ */
+class FlashBlockStore : public BlockStore {
+public:
+  /* @param size Size of the store, a multiple of the last sector's size. */
+  explicit FlashBlockStore(uint32_t size) : address(0), size(size) {}
+
+  bool init() {
+    if (flash.init() != 0) {
+      return false;
+    }
+    const uint32_t flashEnd = flash.get_flash_start() + flash.get_flash_size();
+    address = flashEnd - size;
+    if (size % flash.get_sector_size(flashEnd - 1) != 0) {
+      return false;
+    }
+#if defined(FLASHIAP_APP_ROM_END_ADDR)
+    // Refuse to overlap the program.
+    if (address < FLASHIAP_APP_ROM_END_ADDR) {
+      return false;
+    }
+#endif
+    return true;
+  }
+
+  bool read(uint32_t offset, void *buffer, uint32_t count) {
+    return flash.read(buffer, address + offset, count) == 0;
+  }
+
+  bool program(uint32_t offset, const void *buffer, uint32_t count) {
+    return flash.program(buffer, address + offset, count) == 0;
+  }
+
+  bool erase(uint32_t offset, uint32_t count) {
+    return flash.erase(address + offset, count) == 0;
+  }
+
+  uint32_t getSize() { return size; }
+  uint32_t getEraseSize() { return flash.get_sector_size(address); }
+  uint32_t getProgramSize() { return flash.get_page_size(); }
+  uint8_t getEraseValue() { return flash.get_erase_value(); }
+
+private:
+  FlashIAP flash;   // The internal flash.
+  uint32_t address; // Address of the first byte of the store.
+  uint32_t size;    // Size of the store in bytes.
+};
+#endif
+} // namespace kwin
+
+#endif
@@ -0,0 +1,298 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#include "snapshotStore.h"
+#include <string.h>
+
+// Marks the start of a record.
+static const uint32_t RECORD_MAGIC = 0x4B534E50;
+
+/* @return bool True if the record with sequence number 'sequence' at
+ * 'offset' is newer than the one with 'otherSequence' at 'otherOffset'. */
+static bool isNewerRecord(uint32_t sequence, uint32_t offset,
+                          uint32_t otherSequence, uint32_t otherOffset) {
+  const int32_t difference = (int32_t)(sequence - otherSequence);
+  return difference > 0 || (difference == 0 && offset > otherOffset);
+}
+
+/* @brief Continues a CRC-32 (IEEE 802.3) over 'size' bytes. */
+static uint32_t updateCrc(uint32_t crc, const void *data, uint32_t size) {
+  // Half-byte table, small enough to keep in flash.
+  static const uint32_t TABLE[16] = {
+      0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+      0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+      0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+  const uint8_t *bytes = (const uint8_t *)data;
+  crc = ~crc;
+  for (uint32_t i = 0; i < size; ++i) {
+    crc = TABLE[(crc ^ bytes[i]) & 0x0F] ^ (crc >> 4);
+    crc = TABLE[(crc ^ (bytes[i] >> 4)) & 0x0F] ^ (crc >> 4);
+  }
+  return ~crc;
+}
+
+kwin::SnapshotStore::SnapshotStore(BlockStore &store)
+    : store(store), mounted(false), bankSize(0), programSize(1),
+      headerSize(0), activeBank(0), spareErased(false), cursor(0),
+      sequence(0), hasLatest(false), latestOffset(0), latestSize(0),
+      eraseCount(0) {}
+
+bool kwin::SnapshotStore::restore(void *payload, uint32_t capacity,
+                                  uint32_t *size) {
+  if (!this->mounted && !mount()) {
+    return false;
+  }
+  if (!this->hasLatest || this->latestSize > capacity) {
+    return false;
+  }
+  if (!this->store.read(this->latestOffset + this->headerSize, payload,
+                        this->latestSize)) {
+    return false;
+  }
+  *size = this->latestSize;
+  return true;
+}
+
+bool kwin::SnapshotStore::save(const void *payload, uint32_t size) {
+  if (!this->mounted && !mount()) {
+    return false;
+  }
+
+  const uint32_t recordSize = this->headerSize + alignToProgramSize(size);
+  if (recordSize > this->bankSize) {
+    return false;
+  }
+
+  // Records are only appended to erased space. A record torn by a reset
+  // leaves programmed bytes behind, so the bank is abandoned.
+  const uint32_t bankEnd = (this->activeBank + 1) * this->bankSize;
+  if (this->cursor + recordSize > bankEnd ||
+      !isErased(this->cursor, recordSize)) {
+    if (!switchBank()) {
+      return false;
+    }
+  }
+
+  RecordHeader header;
+  header.magic = RECORD_MAGIC;
+  header.sequence = this->sequence + 1;
+  header.size = size;
+  header.crc = updateCrc(0, &header.sequence, sizeof(header.sequence));
+  header.crc = updateCrc(header.crc, &header.size, sizeof(header.size));
+  header.crc = updateCrc(header.crc, payload, size);
+
+  // Program the payload first and the header last, so a record only
+  // becomes visible once it's complete.
+  const uint32_t payloadOffset = this->cursor + this->headerSize;
+  const uint32_t alignedSize = size - size % this->programSize;
+  if (alignedSize > 0 &&
+      !this->store.program(payloadOffset, payload, alignedSize)) {
+    return false;
+  }
+  uint8_t block[MAX_PROGRAM_SIZE];
+  if (alignedSize < size) {
+    memset(block, this->store.getEraseValue(), sizeof(block));
+    memcpy(block, (const uint8_t *)payload + alignedSize, size - alignedSize);
+    if (!this->store.program(payloadOffset + alignedSize, block,
+                             this->programSize)) {
+      return false;
+    }
+  }
+  memset(block, this->store.getEraseValue(), sizeof(block));
+  memcpy(block, &header, sizeof(header));
+  if (!this->store.program(this->cursor, block, this->headerSize)) {
+    return false;
+  }
+
+  this->sequence = header.sequence;
+  this->hasLatest = true;
+  this->latestOffset = this->cursor;
+  this->latestSize = size;
+  this->cursor += recordSize;
+  return true;
+}
+
+bool kwin::SnapshotStore::needsErase() {
+  if (!this->mounted && !mount()) {
+    return false;
+  }
+  return !this->spareErased;
+}
+
+bool kwin::SnapshotStore::eraseSpareBank() {
+  if (!this->mounted && !mount()) {
+    return false;
+  }
+  if (this->spareErased) {
+    return true;
+  }
+  const int spareBank = 1 - this->activeBank;
+  if (!this->store.erase(spareBank * this->bankSize, this->bankSize)) {
+    return false;
+  }
+  ++this->eraseCount;
+  this->spareErased = true;
+  return true;
+}
+
+bool kwin::SnapshotStore::mount() {
+  if (!this->store.init()) {
+    return false;
+  }
+  const uint32_t eraseSize = this->store.getEraseSize();
+  this->bankSize = this->store.getSize() / 2 / eraseSize * eraseSize;
+  this->programSize = this->store.getProgramSize();
+  if (this->bankSize == 0 || this->programSize > MAX_PROGRAM_SIZE) {
+    return false;
+  }
+  this->headerSize = alignToProgramSize(sizeof(RecordHeader));
+
+  uint32_t recordsEnds[2];
+  uint32_t logEnds[2];
+  scanBank(0, &recordsEnds[0], &logEnds[0]);
+  scanBank(1, &recordsEnds[1], &logEnds[1]);
+  findLatest(recordsEnds);
+
+  // Keep appending to the bank holding the latest snapshot.
+  this->activeBank =
+      this->hasLatest && this->latestOffset >= this->bankSize ? 1 : 0;
+  this->cursor = logEnds[this->activeBank];
+  this->spareErased =
+      isErased((1 - this->activeBank) * this->bankSize, this->bankSize);
+  this->mounted = true;
+  return true;
+}
+
+void kwin::SnapshotStore::scanBank(int bank, uint32_t *recordsEnd,
+                                   uint32_t *logEnd) {
+  uint32_t offset = bank * this->bankSize;
+  const uint32_t end = offset + this->bankSize;
+
+  while (offset + this->headerSize <= end) {
+    RecordHeader header;
+    if (!this->store.read(offset, &header, sizeof(header))) {
+      break;
+    }
+    if (header.magic != RECORD_MAGIC) {
+      // Erased space ends the log, anything else leaves the bank unusable.
+      *recordsEnd = offset;
+      *logEnd = isErased(offset, this->headerSize) ? offset : end;
+      return;
+    }
+
+    const uint32_t recordSize =
+        this->headerSize + alignToProgramSize(header.size);
+    if (header.size > this->bankSize || offset + recordSize > end) {
+      break;
+    }
+    offset += recordSize;
+  }
+  *recordsEnd = offset;
+  *logEnd = end;
+}
+
+void kwin::SnapshotStore::findLatest(const uint32_t recordsEnds[2]) {
+  // Every pass finds the newest record older than the last one that failed
+  // its CRC check. The headers are small, so walking them again is cheap
+  // compared to reading payloads.
+  bool bounded = false;
+  uint32_t boundSequence = 0;
+  uint32_t boundOffset = 0;
+  while (true) {
+    bool found = false;
+    RecordHeader newest;
+    uint32_t newestOffset = 0;
+    for (int bank = 0; bank < 2; ++bank) {
+      uint32_t offset = bank * this->bankSize;
+      while (offset < recordsEnds[bank]) {
+        RecordHeader header;
+        if (!this->store.read(offset, &header, sizeof(header))) {
+          break;
+        }
+        if ((!bounded || isNewerRecord(boundSequence, boundOffset,
+                                       header.sequence, offset)) &&
+            (!found || isNewerRecord(header.sequence, offset,
+                                     newest.sequence, newestOffset))) {
+          found = true;
+          newest = header;
+          newestOffset = offset;
+        }
+        offset += this->headerSize + alignToProgramSize(header.size);
+      }
+    }
+    if (!found) {
+      return;
+    }
+
+    uint32_t crc;
+    if (computeStoredCrc(newest, newestOffset + this->headerSize, &crc) &&
+        crc == newest.crc) {
+      this->hasLatest = true;
+      this->sequence = newest.sequence;
+      this->latestOffset = newestOffset;
+      this->latestSize = newest.size;
+      return;
+    }
+    bounded = true;
+    boundSequence = newest.sequence;
+    boundOffset = newestOffset;
+  }
+}
+
+bool kwin::SnapshotStore::computeStoredCrc(const RecordHeader &header,
+                                           uint32_t payloadOffset,
+                                           uint32_t *crc) {
+  uint32_t result = updateCrc(0, &header.sequence, sizeof(header.sequence));
+  result = updateCrc(result, &header.size, sizeof(header.size));
+
+  uint8_t chunk[64];
+  for (uint32_t done = 0; done < header.size;) {
+    uint32_t chunkSize = header.size - done;
+    if (chunkSize > sizeof(chunk)) {
+      chunkSize = sizeof(chunk);
+    }
+    if (!this->store.read(payloadOffset + done, chunk, chunkSize)) {
+      return false;
+    }
+    result = updateCrc(result, chunk, chunkSize);
+    done += chunkSize;
+  }
+  *crc = result;
+  return true;
+}
+
+bool kwin::SnapshotStore::isErased(uint32_t offset, uint32_t size) {
+  const uint8_t eraseValue = this->store.getEraseValue();
+  uint8_t chunk[64];
+  while (size > 0) {
+    const uint32_t chunkSize = size < sizeof(chunk) ? size : sizeof(chunk);
+    if (!this->store.read(offset, chunk, chunkSize)) {
+      return false;
+    }
+    for (uint32_t i = 0; i < chunkSize; ++i) {
+      if (chunk[i] != eraseValue) {
+        return false;
+      }
+    }
+    offset += chunkSize;
+    size -= chunkSize;
+  }
+  return true;
+}
+
+bool kwin::SnapshotStore::switchBank() {
+  if (!this->spareErased) {
+    return false;
+  }
+  // The full bank becomes the spare, still holding the older snapshots.
+  this->activeBank = 1 - this->activeBank;
+  this->cursor = this->activeBank * this->bankSize;
+  this->spareErased = false;
+  return true;
+}
+
+uint32_t kwin::SnapshotStore::alignToProgramSize(uint32_t size) const {
+  return (size + this->programSize - 1) / this->programSize *
+         this->programSize;
+}
@@ -0,0 +1,136 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#ifndef KWIN_STORAGE_SNAPSHOT_STORE
+#define KWIN_STORAGE_SNAPSHOT_STORE
+
+#include "blockStore.h"
+#include <stdint.h>
+
+namespace kwin {
+
+/*
+ * @brief Keeps the latest snapshot of some state in a BlockStore, surviving
+ * resets and power loss.
+ *
+ *   #Funcional resume:
+ *   The store is split into two banks. Snapshots are appended to the active
+ *   bank as records with a sequence number and a CRC, so many snapshots fit
+ *   between two erases. When the active bank is full, the spare bank becomes
+ *   active. Restoring picks the valid record with the highest sequence
+ *   number, so a snapshot torn by a reset is skipped in favour of the
+ *   previous one. Mounting only reads the record headers, and the payload of
+ *   the newest record to check its CRC, falling back to older records while
+ *   the check fails.
+ *
+ *   Saving never erases. An erase of internal flash stalls the CPU for
+ *   seconds, so the owner erases the spare bank with eraseSpareBank at a
+ *   moment of its choosing, whenever needsErase reports it. Until then, saves
+ *   that don't fit the active bank fail.
+ */
+class SnapshotStore {
+public:
+  // Largest program size of a store the snapshots can be written to.
+  static const uint32_t MAX_PROGRAM_SIZE = 32;
+
+  /* @param store The store, split evenly into two banks of erase units. */
+  explicit SnapshotStore(BlockStore &store);
+
+  /*
+   * @brief Reads the latest snapshot.
+   * @param payload Output for the snapshot.
+   * @param capacity Size of 'payload' in bytes.
+   * @param size Output for the size of the snapshot.
+   * @return bool True if a snapshot was found and fits 'payload'.
+   */
+  bool restore(void *payload, uint32_t capacity, uint32_t *size);
+
+  /*
+   * @brief Appends a snapshot, moving on to the spare bank if the active one
+   * is full. Never erases.
+   * @param payload The snapshot.
+   * @param size Size of the snapshot in bytes.
+   * @return bool True if the snapshot was written, false if it failed or the
+   * active bank is full and the spare bank isn't erased yet.
+   */
+  bool save(const void *payload, uint32_t size);
+
+  /* @return bool True if the spare bank waits for eraseSpareBank. */
+  bool needsErase();
+
+  /*
+   * @brief Erases the spare bank, so saves can move on to it once the active
+   * bank is full. Stalls for as long as the erase takes.
+   * @return bool True if the spare bank is erased.
+   */
+  bool eraseSpareBank();
+
+  /////////////
+  // Getters //
+  /////////////
+
+  /* @return uint32_t Sequence number of the latest snapshot. */
+  uint32_t getSequence() const { return this->sequence; }
+
+  /* @return uint32_t Times a bank was erased since boot. */
+  uint32_t getEraseCount() const { return this->eraseCount; }
+
+private:
+  struct RecordHeader {
+    uint32_t magic;    // RECORD_MAGIC, or erased bytes at the end of a log.
+    uint32_t sequence; // Increases by one per snapshot.
+    uint32_t size;     // Size of the payload.
+    uint32_t crc;      // CRC-32 of the sequence, size and payload.
+  };
+
+  BlockStore &store;       // The underlying store.
+  bool mounted;            // True once the banks were scanned.
+  uint32_t bankSize;       // Size of a bank, a multiple of the erase size.
+  uint32_t programSize;    // Alignment of programmed regions.
+  uint32_t headerSize;     // Bytes a record header occupies.
+  int activeBank;          // Bank snapshots are appended to.
+  bool spareErased;        // True if the other bank is erased.
+  uint32_t cursor;         // Offset of the next record.
+  uint32_t sequence;       // Sequence number of the latest snapshot.
+  bool hasLatest;          // True if a valid snapshot exists.
+  uint32_t latestOffset;   // Offset of the latest snapshot's record.
+  uint32_t latestSize;     // Size of the latest snapshot.
+  uint32_t eraseCount;     // Times a bank was erased.
+
+  /* @brief Finds the latest snapshot and the end of the active bank's log. */
+  bool mount();
+
+  /*
+   * @brief Walks the record headers of a bank, without reading payloads.
+   * @param bank The bank.
+   * @param recordsEnd Output for the end of the bank's well-formed records.
+   * @param logEnd Output for the offset the next record can be appended at,
+   * the end of the bank if the rest isn't erased.
+   */
+  void scanBank(int bank, uint32_t *recordsEnd, uint32_t *logEnd);
+
+  /*
+   * @brief Finds the latest snapshot: the newest record of both banks whose
+   * CRC matches. Only the payloads of the records checked are read.
+   * @param recordsEnds End of the well-formed records of each bank.
+   */
+  void findLatest(const uint32_t recordsEnds[2]);
+
+  /* @brief Computes the CRC-32 of a record, reading its payload from the
+   * store. */
+  bool computeStoredCrc(const RecordHeader &header, uint32_t payloadOffset,
+                        uint32_t *crc);
+
+  /* @return bool True if the region reads as erased. */
+  bool isErased(uint32_t offset, uint32_t size);
+
+  /* @brief Makes the erased spare bank active. */
+  bool switchBank();
+
+  /* @return uint32_t 'size' rounded up to the program size. */
+  uint32_t alignToProgramSize(uint32_t size) const;
+};
+} // namespace kwin
+
+#endif
@@ -0,0 +1,288 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#ifndef KWIN_UTILS_ALARMS
+#define KWIN_UTILS_ALARMS
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace kwin {
+
+/* @brief What an alarm rule compares against its threshold. */
+enum AlarmKind {
+  ALARM_ABOVE,      // Raised when the value rises to or above the threshold.
+  ALARM_BELOW,      // Raised when the value falls to or below the threshold.
+  ALARM_RISE_RATE,  // Raised when the value rises at least threshold/second.
+  ALARM_FALL_RATE   // Raised when the value falls at least threshold/second.
+};
+
+/*
+ * @brief An alarm rule as written by the user.
+ */
+struct AlarmRule {
+  const char *name;           // Name shown when the alarm is raised.
+  uint16_t sensorId;          // Sensor the rule applies to.
+  AlarmKind kind;             // What the threshold is compared against.
+  float threshold;            // Level at which the alarm is raised.
+  float hysteresis;           // Distance back past the threshold to clear.
+  uint32_t minimumDurationMs; // How long the condition must hold to raise.
+};
+
+/*
+ * @brief Raising or clearing of an alarm.
+ */
+struct AlarmEvent {
+  uint16_t ruleIndex; // Index of the rule, in the order it was added.
+  uint16_t sensorId;  // Sensor the rule applies to.
+  bool raised;        // True if raised, false if cleared.
+  float value;        // The value (or rate) that triggered the event.
+  uint32_t timeMs;    // Time of the sample that triggered the event.
+};
+
+/*
+ * @brief Incremental threshold alarm engine.
+ *
+ *   #Funcional resume:
+ *   Rules are added with addRule and compiled into a table grouped by sensor.
+ *   Every sample is passed to update, which only evaluates the rules of that
+ *   sample's sensor, so the cost per sample is O(rules of the sensor).
+ *   Rules raise after their condition held for their minimum duration and
+ *   clear once the value is back past the threshold by the hysteresis.
+ *   Storage is static, sized by the template parameters.
+ */
+template <int MaxRules, int MaxSensors> class AlarmEngine {
+public:
+  /////////////////////
+  // Event Listeners //
+  /////////////////////
+
+  void (*onAlarm)(const AlarmEvent &event) = NULL; // Function pointer
+                                                   // representing a listener
+                                                   // for raised and cleared
+                                                   // alarms.
+
+  ////////////////////////
+  // Public Constructor //
+  ////////////////////////
+
+  AlarmEngine()
+      : ruleCount(0), activeAlarmCount(0), raiseCount(0), compiled(true) {
+    for (int i = 0; i <= MaxSensors; ++i) {
+      sensorRuleOffsets[i] = 0;
+    }
+    for (int i = 0; i < MaxSensors; ++i) {
+      sensors[i].hasSample = false;
+    }
+  }
+
+  ////////////////////
+  // Public Methods //
+  ////////////////////
+
+  /*
+   * @brief Adds a rule. compile must be called before the next update.
+   * @param rule The rule to add.
+   * @return bool False if the rule table is full or the sensor is unknown.
+   */
+  bool addRule(const AlarmRule &rule) {
+    if (ruleCount >= MaxRules || rule.sensorId >= MaxSensors) {
+      return false;
+    }
+    rules[ruleCount++] = rule;
+    compiled = false;
+    return true;
+  }
+
+  /*
+   * @brief Compiles the rules into the per-sensor evaluation table, resetting
+   * all alarm states.
+   */
+  void compile() {
+    // Counting sort of the rules by sensor.
+    for (int i = 0; i <= MaxSensors; ++i) {
+      sensorRuleOffsets[i] = 0;
+    }
+    for (int i = 0; i < ruleCount; ++i) {
+      ++sensorRuleOffsets[rules[i].sensorId + 1];
+    }
+    for (int i = 0; i < MaxSensors; ++i) {
+      sensorRuleOffsets[i + 1] += sensorRuleOffsets[i];
+    }
+
+    uint16_t nextSlot[MaxSensors];
+    for (int i = 0; i < MaxSensors; ++i) {
+      nextSlot[i] = sensorRuleOffsets[i];
+    }
+
+    for (int i = 0; i < ruleCount; ++i) {
+      const AlarmRule &rule = rules[i];
+      CompiledRule &entry = table[nextSlot[rule.sensorId]++];
+
+      // Rules are normalized so 'BELOW' and 'FALL' compare negated values.
+      const bool isNegated =
+          rule.kind == ALARM_BELOW || rule.kind == ALARM_FALL_RATE;
+      entry.sign = isNegated ? -1.0f : 1.0f;
+      entry.usesRate =
+          rule.kind == ALARM_RISE_RATE || rule.kind == ALARM_FALL_RATE;
+      // Rate thresholds are magnitudes: 'falls at least threshold/second'.
+      entry.raiseLevel =
+          entry.usesRate ? rule.threshold : entry.sign * rule.threshold;
+      entry.clearLevel = entry.raiseLevel - rule.hysteresis;
+      entry.minimumDurationMs = rule.minimumDurationMs;
+      entry.ruleIndex = i;
+      entry.active = false;
+      entry.pending = false;
+      entry.conditionSinceMs = 0;
+      entry.raiseNumber = 0;
+    }
+
+    for (int i = 0; i < MaxSensors; ++i) {
+      sensors[i].hasSample = false;
+    }
+    activeAlarmCount = 0;
+    raiseCount = 0;
+    compiled = true;
+  }
+
+  /*
+   * @brief Evaluates the rules of a sensor against a new sample.
+   * @param sensorId The sensor the sample is from.
+   * @param value The sample value.
+   * @param timeMs Time of the sample in milliseconds.
+   */
+  void update(uint16_t sensorId, float value, uint32_t timeMs) {
+    if (!compiled || sensorId >= MaxSensors) {
+      return;
+    }
+
+    // Rate of change per second since the previous sample of the sensor.
+    SensorState &sensor = sensors[sensorId];
+    float rate = 0.0f;
+    const bool hasRate = sensor.hasSample && timeMs != sensor.lastTimeMs;
+    if (hasRate) {
+      rate = (value - sensor.lastValue) * 1000.0f /
+             (int32_t)(timeMs - sensor.lastTimeMs);
+    }
+    sensor.lastValue = value;
+    sensor.lastTimeMs = timeMs;
+    sensor.hasSample = true;
+
+    const int end = sensorRuleOffsets[sensorId + 1];
+    for (int i = sensorRuleOffsets[sensorId]; i < end; ++i) {
+      CompiledRule &entry = table[i];
+      if (entry.usesRate && !hasRate) {
+        continue;
+      }
+      const float measured = entry.usesRate ? rate : value;
+      const float level = entry.sign * measured;
+
+      if (entry.active) {
+        if (level < entry.clearLevel) {
+          entry.active = false;
+          entry.pending = false;
+          --activeAlarmCount;
+          evokeOnAlarm(entry, sensorId, false, measured, timeMs);
+        }
+      } else if (level >= entry.raiseLevel) {
+        if (!entry.pending) {
+          entry.pending = true;
+          entry.conditionSinceMs = timeMs;
+        }
+        if (timeMs - entry.conditionSinceMs >= entry.minimumDurationMs) {
+          entry.active = true;
+          entry.raiseNumber = ++raiseCount;
+          ++activeAlarmCount;
+          evokeOnAlarm(entry, sensorId, true, measured, timeMs);
+        }
+      } else {
+        entry.pending = false; // Condition dropped before being debounced.
+      }
+    }
+  }
+
+  /////////////////////////
+  // Getters and Setters //
+  /////////////////////////
+
+  int getRuleCount() { return ruleCount; }
+  int getActiveAlarmCount() { return activeAlarmCount; }
+
+  /*
+   * @brief Finds the most recently raised alarm that is still active. Scans
+   * the rules, so call it from the thread calling update, e.g. from onAlarm.
+   * @return int Index of the alarm's rule, or -1 if no alarm is active.
+   */
+  int getLatestActiveRuleIndex() {
+    int latestRuleIndex = -1;
+    uint32_t latestRaiseNumber = 0;
+    for (int i = 0; i < ruleCount; ++i) {
+      const CompiledRule &entry = table[i];
+      if (entry.active && entry.raiseNumber > latestRaiseNumber) {
+        latestRuleIndex = entry.ruleIndex;
+        latestRaiseNumber = entry.raiseNumber;
+      }
+    }
+    return latestRuleIndex;
+  }
+
+  /*
+   * @brief Getter method for a rule.
+   * @param ruleIndex Index of the rule, in the order it was added.
+   */
+  const AlarmRule &getRule(int ruleIndex) { return rules[ruleIndex]; }
+
+private:
+  /* @brief Rule as laid out for evaluation. */
+  struct CompiledRule {
+    float raiseLevel;           // Normalized level at which to raise.
+    float clearLevel;           // Normalized level below which to clear.
+    float sign;                 // -1 for rules comparing negated values.
+    uint32_t minimumDurationMs; // How long the condition must hold to raise.
+    uint32_t conditionSinceMs;  // When the pending condition started.
+    uint32_t raiseNumber;       // Order in which the alarm was last raised.
+    uint16_t ruleIndex;         // Index into 'rules'.
+    bool usesRate;              // Compare the rate instead of the value.
+    bool pending;               // Condition holds, but not long enough yet.
+    bool active;                // The alarm is raised.
+  };
+
+  /* @brief Previous sample of a sensor, for rate of change rules. */
+  struct SensorState {
+    float lastValue;
+    uint32_t lastTimeMs;
+    bool hasSample;
+  };
+
+  ////////////////////
+  // Private Fields //
+  ////////////////////
+
+  AlarmRule rules[MaxRules];                // Rules in the order added.
+  CompiledRule table[MaxRules];             // Rules grouped by sensor.
+  uint16_t sensorRuleOffsets[MaxSensors + 1]; // First table entry per sensor.
+  SensorState sensors[MaxSensors];          // Previous sample per sensor.
+  int ruleCount;                            // Amount of rules.
+  volatile int activeAlarmCount;            // Amount of raised alarms.
+  uint32_t raiseCount;                      // Alarms raised since compile.
+  bool compiled;                            // False if rules were added
+                                            // since the last compile.
+
+  /////////////////////
+  // Private Methods //
+  /////////////////////
+
+  /* @brief Method for evoking the onAlarm event */
+  void evokeOnAlarm(const CompiledRule &entry, uint16_t sensorId, bool raised,
+                    float value, uint32_t timeMs) {
+    /* Only evoke the event if it is set */
+    if (this->onAlarm != NULL) {
+      AlarmEvent event = {entry.ruleIndex, sensorId, raised, value, timeMs};
+      this->onAlarm(event);
+    }
+  }
+};
+} // namespace kwin
+
+#endif
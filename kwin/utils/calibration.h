@@ -0,0 +1,118 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#ifndef KWIN_UTILS_CALIBRATION
+#define KWIN_UTILS_CALIBRATION
+
+#include "temperatureConversion.h"
+#include <stddef.h>
+#include <stdint.h>
+
+namespace kwin {
+
+/*
+ * @brief A raw sensor reading and the value it corresponds to.
+ */
+struct CalibrationPoint {
+  float raw;        // The reading, e.g. an ADC fraction between 0 and 1.
+  float calibrated; // The calibrated value, e.g. lux.
+};
+
+/*
+ * @brief Interpolates linearly between calibration points.
+ * Readings outside the points get the value of the nearest point.
+ * @param points The calibration points, sorted by raw reading.
+ * @param pointCount Amount of points.
+ * @param raw The reading.
+ * @return float The calibrated value.
+ */
+constexpr float interpolateCalibration(const CalibrationPoint *points,
+                                       size_t pointCount, float raw) {
+  if (raw <= points[0].raw) {
+    return points[0].calibrated;
+  }
+  for (size_t i = 1; i < pointCount; ++i) {
+    if (raw <= points[i].raw) {
+      const CalibrationPoint &low = points[i - 1];
+      const CalibrationPoint &high = points[i];
+      return low.calibrated + (high.calibrated - low.calibrated) *
+                                  (raw - low.raw) / (high.raw - low.raw);
+    }
+  }
+  return points[pointCount - 1].calibrated;
+}
+
+/*
+ * @brief Lookup table linearizing a 16-bit ADC reading, generated at compile
+ * time from calibration points.
+ *
+ *   #Funcional resume:
+ *   The table holds the calibrated value of 2^IndexBits + 1 evenly spaced
+ *   readings between 0 and 1. A lookup indexes the table with the high bits
+ *   of the reading and interpolates with the low bits, so it costs one
+ *   multiply-add, with no search and no pow or log calls. Declare the table
+ *   constexpr, so it's generated by the compiler and placed in flash.
+ */
+template <int IndexBits> class CalibrationTable {
+public:
+  static_assert(IndexBits > 0 && IndexBits <= 12,
+                "IndexBits must be between 1 and 12");
+
+  static const int SIZE = (1 << IndexBits) + 1; // Amount of table entries.
+
+  /*
+   * @brief Generates the table.
+   * @param points The calibration points, sorted by raw reading between 0
+   * and 1.
+   */
+  template <size_t PointCount>
+  constexpr CalibrationTable(const CalibrationPoint (&points)[PointCount])
+      : values() {
+    for (int i = 0; i < SIZE; ++i) {
+      values[i] = interpolateCalibration(points, PointCount,
+                                         (float)i / (float)(SIZE - 1));
+    }
+  }
+
+  /*
+   * @brief Calibrates a reading as returned by AnalogIn::read_u16.
+   * @param raw The reading.
+   * @return float The calibrated value.
+   */
+  float lookup(uint16_t raw) const {
+    const uint32_t index = raw >> FRACTION_BITS;
+    const uint32_t fraction = raw & ((1 << FRACTION_BITS) - 1);
+    return values[index] + (values[index + 1] - values[index]) *
+                               (float)fraction * FRACTION_SCALE;
+  }
+
+  /* @return float The calibrated value of table entry 'index'. */
+  constexpr float getValue(int index) const { return values[index]; }
+
+private:
+  static const int FRACTION_BITS = 16 - IndexBits; // Bits interpolated.
+  static constexpr float FRACTION_SCALE = 1.0f / (1 << FRACTION_BITS);
+
+  float values[SIZE]; // Calibrated value of every table entry.
+};
+
+template <int IndexBits>
+constexpr float CalibrationTable<IndexBits>::FRACTION_SCALE;
+
+/*
+ * @brief Creates the offset and gain correction through two reference
+ * points, e.g. readings of a sensor at two known temperatures.
+ * @param low The reference point with the lowest reading.
+ * @param high The reference point with the highest reading.
+ * @return LinearConversion<float> The correction.
+ */
+constexpr LinearConversion<float>
+makeLinearCalibration(CalibrationPoint low, CalibrationPoint high) {
+  return {(high.calibrated - low.calibrated) / (high.raw - low.raw),
+          low.calibrated - low.raw * (high.calibrated - low.calibrated) /
+                               (high.raw - low.raw)};
+}
+} // namespace kwin
+
+#endif
@@ -0,0 +1,111 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#ifndef KWIN_UTILS_DELEGATE
+#define KWIN_UTILS_DELEGATE
+
+#include <new>
+#include <stddef.h>
+#include <type_traits>
+#include <utility>
+
+namespace kwin {
+
+template <typename Signature> class Delegate;
+
+/*
+ * @brief Callable reference with inline storage, never allocating.
+ *
+ *   #Funcional resume:
+ *   A Delegate stores a plain function pointer, a member function bound to
+ *   an object, or a function object such as a capturing lambda. Function
+ *   objects are copied into a small inline buffer; ones that don't fit, or
+ *   aren't trivially copyable, are rejected at compile time.
+ */
+template <typename R, typename... Args> class Delegate<R(Args...)> {
+public:
+  // Bytes available for a bound function object, e.g. a lambda capturing
+  // up to three pointers.
+  static const size_t STORAGE_SIZE = 3 * sizeof(void *);
+
+  /* @brief Creates an empty delegate. */
+  Delegate() : invoker(NULL) {}
+
+  /*
+   * @brief Creates a delegate calling a function pointer.
+   * @param function The function to call, or NULL for an empty delegate.
+   */
+  Delegate(R (*function)(Args...)) : invoker(NULL) {
+    if (function != NULL) {
+      new (storage) FunctionPointer(function);
+      invoker = &invokeStored<FunctionPointer>;
+    }
+  }
+
+  /*
+   * @brief Creates a delegate calling a function object, e.g. a lambda.
+   * @param function The function object, copied into the delegate.
+   */
+  template <typename F,
+            typename = typename std::enable_if<
+                !std::is_same<typename std::decay<F>::type,
+                              Delegate>::value>::type,
+            typename = decltype(std::declval<F &>()(std::declval<Args>()...))>
+  Delegate(F function) : invoker(NULL) {
+    static_assert(sizeof(F) <= STORAGE_SIZE,
+                  "The function object doesn't fit in the delegate");
+    static_assert(alignof(F) <= alignof(void *),
+                  "The function object is aligned too strictly");
+    static_assert(std::is_trivially_copyable<F>::value,
+                  "The function object must be trivially copyable");
+    new (storage) F(function);
+    invoker = &invokeStored<F>;
+  }
+
+  /*
+   * @brief Creates a delegate calling a member function of an object.
+   * @param object The object, which must outlive the delegate.
+   * @return Delegate The bound delegate.
+   */
+  template <typename T, R (T::*Method)(Args...)>
+  static Delegate fromMethod(T *object) {
+    Delegate delegate;
+    new (delegate.storage) T *(object);
+    delegate.invoker = &invokeMethod<T, Method>;
+    return delegate;
+  }
+
+  /* @brief Calls the bound function. The delegate must not be empty. */
+  R operator()(Args... args) const {
+    return invoker(storage, std::forward<Args>(args)...);
+  }
+
+  /* @return bool True if a function is bound. */
+  explicit operator bool() const { return invoker != NULL; }
+
+  bool operator==(decltype(nullptr)) const { return invoker == NULL; }
+  bool operator!=(decltype(nullptr)) const { return invoker != NULL; }
+
+private:
+  typedef R (*FunctionPointer)(Args...);
+  typedef R (*Invoker)(const void *storage, Args... args);
+
+  alignas(void *) unsigned char storage[STORAGE_SIZE]; // The bound callable.
+  Invoker invoker; // Calls the callable in 'storage'. NULL if empty.
+
+  template <typename F>
+  static R invokeStored(const void *storage, Args... args) {
+    F &function = *const_cast<F *>(static_cast<const F *>(storage));
+    return function(std::forward<Args>(args)...);
+  }
+
+  template <typename T, R (T::*Method)(Args...)>
+  static R invokeMethod(const void *storage, Args... args) {
+    T *object = *static_cast<T *const *>(storage);
+    return (object->*Method)(std::forward<Args>(args)...);
+  }
+};
+} // namespace kwin
+
+#endif
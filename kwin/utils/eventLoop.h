@@ -0,0 +1,309 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#ifndef KWIN_UTILS_EVENT_LOOP
+#define KWIN_UTILS_EVENT_LOOP
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__MBED__)
+#include "mbed.h"
+#endif
+
+namespace kwin {
+
+/*
+ * @brief Time source and idle primitive of an EventLoop.
+ */
+class EventClock {
+public:
+  virtual ~EventClock() {}
+
+  /* @return uint32_t The current time in microseconds. Allowed to wrap. */
+  virtual uint32_t nowUs() = 0;
+
+  /*
+   * @brief Idles until 'deadlineUs', or until wake is called. A wake that
+   * happened before this call makes it return immediately.
+   * @param deadlineUs Time at which to stop idling.
+   */
+  virtual void waitUntil(uint32_t deadlineUs) = 0;
+
+  /* @brief Stops the current or next waitUntil. Safe from any thread. */
+  virtual void wake() = 0;
+};
+
+/*
+ * @brief Simulated clock for running an EventLoop on a host.
+ * Idling jumps straight to the deadline, and work takes no time unless
+ * advance is called, so the loop's accounting can be checked exactly.
+ */
+class VirtualClock : public EventClock {
+public:
+  VirtualClock() : time(0), woken(false) {}
+
+  uint32_t nowUs() { return time; }
+
+  void waitUntil(uint32_t deadlineUs) {
+    if (!woken && (int32_t)(deadlineUs - time) > 0) {
+      time = deadlineUs;
+    }
+    woken = false;
+  }
+
+  void wake() { woken = true; }
+
+  /*
+   * @brief Moves the time forward, e.g. to simulate the cost of a handler.
+   * @param us Amount of microseconds to advance.
+   */
+  void advance(uint32_t us) { time += us; }
+
+private:
+  uint32_t time; // The current time in microseconds.
+  bool woken;    // True if wake was called since the last waitUntil.
+};
+
+#if defined(__MBED__)
+/*
+ * @brief Clock of the board. Idles by blocking the event loop thread, which
+ * lets the RTOS idle thread put the MCU to sleep until the deadline or wake.
+ * The sleep only lasts until the deadline in tickless builds, MBED_TICKLESS is
+ * set in mbed_app.json; otherwise SysTick wakes the MCU every millisecond.
+ */
+class MbedClock : public EventClock {
+public:
+  uint32_t nowUs() { return us_ticker_read(); }
+
+  void waitUntil(uint32_t deadlineUs) {
+    const int32_t remainingUs = deadlineUs - nowUs();
+    if (remainingUs <= 0) {
+      flags.clear(WAKE_FLAG);
+      return;
+    }
+    // Round up, so the deadline has passed when the wait times out.
+    flags.wait_any(WAKE_FLAG, (remainingUs + 999) / 1000);
+  }
+
+  void wake() { flags.set(WAKE_FLAG); }
+
+private:
+  static const uint32_t WAKE_FLAG = 1;
+  rtos::EventFlags flags; // Set by wake, cleared by waitUntil.
+};
+#endif
+
+/*
+ * @brief Run statistics of one task of an EventLoop.
+ */
+struct TaskStatistics {
+  const char *name;  // Name of the task.
+  uint32_t runCount; // Times the task ran since the accounting was reset.
+  float utilization; // Percentage of time spent running the task.
+};
+
+/*
+ * @brief Single-threaded, event-driven scheduler.
+ *
+ *   #Funcional resume:
+ *   Tasks are either timers, which run periodically, or events, which run
+ *   once per post. Posting is safe from any thread or interrupt. Between
+ *   tasks the loop idles on its EventClock until the next timer is due or an
+ *   event is posted. The time spent in every task and idling is accounted,
+ *   so the remaining CPU headroom can be reported.
+ */
+template <int MaxTasks> class EventLoop {
+public:
+  ////////////////////////
+  // Public Constructor //
+  ////////////////////////
+
+  /*
+   * @brief EventLoop class constructor.
+   * @param clock Time source and idle primitive of the loop.
+   */
+  EventLoop(EventClock &clock) : clock(clock), taskCount(0), pending(0) {
+    static_assert(MaxTasks <= 32, "Pending events are kept in a 32-bit mask");
+    resetAccounting();
+  }
+
+  ////////////////////
+  // Public Methods //
+  ////////////////////
+
+  /*
+   * @brief Adds a task that runs periodically, first one period from now.
+   * @param name Name of the task, used in reports.
+   * @param periodUs Period of the task in microseconds.
+   * @param handler Function to run.
+   * @return int Identifier of the task, or -1 if there is no room.
+   */
+  int addTimer(const char *name, uint32_t periodUs, void (*handler)()) {
+    const int taskId = addTask(name, handler);
+    if (taskId >= 0) {
+      tasks[taskId].periodUs = periodUs;
+      tasks[taskId].nextRunUs = clock.nowUs() + periodUs;
+    }
+    return taskId;
+  }
+
+  /*
+   * @brief Adds a task that runs once every time it is posted.
+   * @param name Name of the task, used in reports.
+   * @param handler Function to run.
+   * @return int Identifier of the task, or -1 if there is no room.
+   */
+  int addEvent(const char *name, void (*handler)()) {
+    return addTask(name, handler);
+  }
+
+  /*
+   * @brief Schedules an event task to run. Safe from any thread or interrupt.
+   * Posting an already pending event has no additional effect.
+   * @param taskId Identifier of the task.
+   */
+  void post(int taskId) {
+    pending.fetch_or(1u << taskId);
+    clock.wake();
+  }
+
+  /* @brief Runs all due tasks, then idles until there is more work. */
+  void runOnce() {
+    const uint32_t now = clock.nowUs();
+
+    // Run the due timers.
+    for (int i = 0; i < taskCount; ++i) {
+      Task &task = tasks[i];
+      if (task.periodUs == 0 || (int32_t)(now - task.nextRunUs) < 0) {
+        continue;
+      }
+      task.nextRunUs += task.periodUs;
+      // Skip the missed periods instead of running the task in a burst.
+      if ((int32_t)(now - task.nextRunUs) >= 0) {
+        task.nextRunUs = now + task.periodUs;
+      }
+      runTask(task);
+    }
+
+    // Run the posted events.
+    const uint32_t posted = pending.exchange(0);
+    for (int i = 0; i < taskCount; ++i) {
+      if (posted & (1u << i)) {
+        runTask(tasks[i]);
+      }
+    }
+
+    // Idle until the next timer is due, or something is posted.
+    uint32_t deadline = clock.nowUs() + MAX_IDLE_US;
+    for (int i = 0; i < taskCount; ++i) {
+      if (tasks[i].periodUs != 0 &&
+          (int32_t)(tasks[i].nextRunUs - deadline) < 0) {
+        deadline = tasks[i].nextRunUs;
+      }
+    }
+    const uint32_t idleStart = clock.nowUs();
+    clock.waitUntil(deadline);
+    idleUs += clock.nowUs() - idleStart;
+  }
+
+  /* @brief Runs the loop forever. */
+  void run() {
+    while (true) {
+      runOnce();
+    }
+  }
+
+  /* @brief Restarts the utilization accounting window. */
+  void resetAccounting() {
+    accountingStartUs = clock.nowUs();
+    idleUs = 0;
+    for (int i = 0; i < taskCount; ++i) {
+      tasks[i].runCount = 0;
+      tasks[i].busyUs = 0;
+    }
+  }
+
+  /////////////////////////
+  // Getters and Setters //
+  /////////////////////////
+
+  int getTaskCount() { return taskCount; }
+
+  /*
+   * @brief Getter method for the statistics of a task since the accounting
+   * was reset.
+   * @param taskId Identifier of the task.
+   */
+  TaskStatistics getTaskStatistics(int taskId) {
+    TaskStatistics statistics;
+    statistics.name = tasks[taskId].name;
+    statistics.runCount = tasks[taskId].runCount;
+    statistics.utilization = percentageOfWindow(tasks[taskId].busyUs);
+    return statistics;
+  }
+
+  /* @return float Percentage of time spent idling since the accounting was
+   * reset. */
+  float getIdlePercentage() { return percentageOfWindow(idleUs); }
+
+private:
+  // Longest idle period when there are no timers.
+  static const uint32_t MAX_IDLE_US = 1000000;
+
+  /* @brief A timer or event task. */
+  struct Task {
+    const char *name;   // Name of the task, used in reports.
+    void (*handler)();  // Function to run.
+    uint32_t periodUs;  // Period of a timer, zero for events.
+    uint32_t nextRunUs; // When a timer is due next.
+    uint32_t runCount;  // Runs since the accounting was reset.
+    uint32_t busyUs;    // Time spent running since the accounting was reset.
+  };
+
+  ////////////////////
+  // Private Fields //
+  ////////////////////
+
+  EventClock &clock;              // Time source and idle primitive.
+  Task tasks[MaxTasks];           // The tasks.
+  int taskCount;                  // Amount of tasks.
+  std::atomic<uint32_t> pending;  // Mask of posted events.
+  uint32_t accountingStartUs;     // Start of the accounting window.
+  uint32_t idleUs;                // Time spent idling within the window.
+
+  /////////////////////
+  // Private Methods //
+  /////////////////////
+
+  int addTask(const char *name, void (*handler)()) {
+    if (taskCount >= MaxTasks) {
+      return -1;
+    }
+    Task &task = tasks[taskCount];
+    task.name = name;
+    task.handler = handler;
+    task.periodUs = 0;
+    task.nextRunUs = 0;
+    task.runCount = 0;
+    task.busyUs = 0;
+    return taskCount++;
+  }
+
+  void runTask(Task &task) {
+    const uint32_t start = clock.nowUs();
+    task.handler();
+    task.busyUs += clock.nowUs() - start;
+    ++task.runCount;
+  }
+
+  float percentageOfWindow(uint32_t us) {
+    const uint32_t windowUs = clock.nowUs() - accountingStartUs;
+    return windowUs > 0 ? 100.0f * us / windowUs : 0.0f;
+  }
+};
+} // namespace kwin
+
+#endif
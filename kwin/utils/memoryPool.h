@@ -0,0 +1,165 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#ifndef KWIN_UTILS_MEMORY_POOL
+#define KWIN_UTILS_MEMORY_POOL
+
+#include <new>
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+
+namespace kwin {
+
+/*
+ * @brief Usage counters of a pool or arena.
+ * Pools count in blocks, arenas count in bytes.
+ */
+struct AllocatorStatistics {
+  size_t capacity;           // Total amount of blocks or bytes.
+  size_t used;               // Blocks or bytes currently in use.
+  size_t highWaterMark;      // Most blocks or bytes ever in use at once.
+  size_t failedAllocations;  // Allocations that did not fit.
+};
+
+/*
+ * @brief Fixed-block pool of up to N objects of type T, in static storage.
+ * Allocation and release are constant time and never fragment. Not thread
+ * safe; create and destroy objects from one thread, or during initialization.
+ */
+template <typename T, int N> class ObjectPool {
+public:
+  ObjectPool() : freeList(NULL), used(0), highWaterMark(0), failed(0) {
+    // Chain all blocks into the free list.
+    for (int i = N - 1; i >= 0; --i) {
+      blocks[i].next = freeList;
+      freeList = &blocks[i];
+    }
+  }
+
+  /*
+   * @brief Constructs an object in a free block.
+   * @param args Arguments passed to the constructor of T.
+   * @return T* The object, or NULL if the pool is exhausted.
+   */
+  template <typename... Args> T *create(Args &&... args) {
+    if (freeList == NULL) {
+      ++failed;
+      return NULL;
+    }
+    Block *block = freeList;
+    freeList = block->next;
+    if (++used > highWaterMark) {
+      highWaterMark = used;
+    }
+    return new (block->storage) T(std::forward<Args>(args)...);
+  }
+
+  /*
+   * @brief Destroys an object and returns its block to the pool.
+   * @param object An object created by this pool, or NULL.
+   */
+  void destroy(T *object) {
+    if (object == NULL) {
+      return;
+    }
+    object->~T();
+    Block *block = reinterpret_cast<Block *>(object);
+    block->next = freeList;
+    freeList = block;
+    --used;
+  }
+
+  /* @return AllocatorStatistics The usage counters, in blocks. */
+  AllocatorStatistics getStatistics() const {
+    AllocatorStatistics statistics = {N, used, highWaterMark, failed};
+    return statistics;
+  }
+
+private:
+  /* @brief Storage of one object, linked into the free list while unused. */
+  union Block {
+    Block *next;
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  Block blocks[N];      // Storage of the objects.
+  Block *freeList;      // First unused block.
+  size_t used;          // Blocks in use.
+  size_t highWaterMark; // Most blocks ever in use at once.
+  size_t failed;        // Allocations that did not fit.
+};
+
+/*
+ * @brief Bytes an Arena needs to create 'count' objects of type T in a row,
+ * including the worst case padding to align the first of them.
+ * @param count Amount of objects.
+ * @return size_t The size to add to the arena's 'Bytes'.
+ */
+template <typename T> constexpr size_t arenaBytesFor(size_t count = 1) {
+  return count * sizeof(T) + alignof(T) - 1;
+}
+
+/*
+ * @brief Bump allocator over a static buffer of 'Bytes' bytes.
+ * Meant for components that are created once and live forever. Memory is
+ * only returned all at once by reset, which does not run destructors. Size
+ * it with arenaBytesFor.
+ */
+template <size_t Bytes> class Arena {
+public:
+  Arena() : used(0), highWaterMark(0), failed(0) {}
+
+  /*
+   * @brief Allocates raw memory.
+   * @param size Amount of bytes.
+   * @param alignment Required alignment, a power of two.
+   * @return void* The memory, or NULL if the arena is exhausted.
+   */
+  void *allocate(size_t size, size_t alignment) {
+    const uintptr_t base = reinterpret_cast<uintptr_t>(storage);
+    const uintptr_t start = (base + used + alignment - 1) & ~(alignment - 1);
+    const size_t end = start - base + size;
+    if (end > Bytes) {
+      ++failed;
+      return NULL;
+    }
+    used = end;
+    if (used > highWaterMark) {
+      highWaterMark = used;
+    }
+    return reinterpret_cast<void *>(start);
+  }
+
+  /*
+   * @brief Constructs an object in the arena.
+   * @param args Arguments passed to the constructor of T.
+   * @return T* The object, or NULL if the arena is exhausted.
+   */
+  template <typename T, typename... Args> T *create(Args &&... args) {
+    void *memory = allocate(sizeof(T), alignof(T));
+    if (memory == NULL) {
+      return NULL;
+    }
+    return new (memory) T(std::forward<Args>(args)...);
+  }
+
+  /* @brief Releases all memory. Objects in the arena are not destroyed. */
+  void reset() { used = 0; }
+
+  /* @return AllocatorStatistics The usage counters, in bytes. */
+  AllocatorStatistics getStatistics() const {
+    AllocatorStatistics statistics = {Bytes, used, highWaterMark, failed};
+    return statistics;
+  }
+
+private:
+  alignas(8) unsigned char storage[Bytes]; // The memory handed out.
+  size_t used;                             // Bytes in use.
+  size_t highWaterMark;                    // Most bytes ever in use.
+  size_t failed;                           // Allocations that did not fit.
+};
+} // namespace kwin
+
+#endif
@@ -0,0 +1,105 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#ifndef KWIN_UTILS_RING_BUFFER
+#define KWIN_UTILS_RING_BUFFER
+
+#include <stddef.h>
+
+namespace kwin {
+
+/*
+ * @brief Fixed-capacity FIFO of up to N elements, in static storage.
+ * Pushing onto a full buffer overwrites the oldest element, so it never
+ * allocates. Offers the subset of the std::deque interface used for
+ * sample histories.
+ */
+template <typename T, int N> class RingBuffer {
+public:
+  /* @brief Read-only iterator from the oldest to the newest element. */
+  class const_iterator {
+  public:
+    const_iterator() : buffer(NULL), index(0) {}
+
+    const_iterator(const RingBuffer *buffer, size_t index)
+        : buffer(buffer), index(index) {}
+
+    const T &operator*() const { return buffer->at(index); }
+
+    const_iterator &operator++() {
+      ++index;
+      return *this;
+    }
+
+    bool operator==(const const_iterator &other) const {
+      return index == other.index && buffer == other.buffer;
+    }
+
+    bool operator!=(const const_iterator &other) const {
+      return !(*this == other);
+    }
+
+  private:
+    const RingBuffer *buffer; // The buffer iterated over.
+    size_t index;             // Index of the element, oldest being 0.
+  };
+
+  RingBuffer() : first(0), count(0) {}
+
+  /*
+   * @brief Appends an element, overwriting the oldest one if full.
+   * @param value The element to append.
+   */
+  void push_back(const T &value) {
+    if (count < N) {
+      elements[(first + count) % N] = value;
+      ++count;
+    } else {
+      elements[first] = value;
+      first = (first + 1) % N;
+    }
+  }
+
+  /*
+   * @brief Removes the oldest elements.
+   * @param amount Amount of elements to remove.
+   */
+  void pop_front(size_t amount = 1) {
+    if (amount > count) {
+      amount = count;
+    }
+    first = (first + amount) % N;
+    count -= amount;
+  }
+
+  /* @brief Removes all elements. */
+  void clear() {
+    first = 0;
+    count = 0;
+  }
+
+  /*
+   * @param index Index of the element, the oldest being 0.
+   * @return const T& The element.
+   */
+  const T &at(size_t index) const { return elements[(first + index) % N]; }
+
+  const T &front() const { return at(0); }
+  const T &back() const { return at(count - 1); }
+
+  size_t size() const { return count; }
+  static size_t capacity() { return N; }
+  bool empty() const { return count == 0; }
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, count); }
+
+private:
+  T elements[N]; // Storage of the elements.
+  size_t first;  // Index of the oldest element.
+  size_t count;  // Amount of elements.
+};
+} // namespace kwin
+
+#endif
@@ -0,0 +1,544 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#ifndef KWIN_UTILS_STATISTICS
+#define KWIN_UTILS_STATISTICS
+
+#include <atomic>
+#include <stdint.h>
+
+namespace kwin {
+
+/*
+ * @brief Running mean and variance using Welford's algorithm.
+ * Samples can be removed again, which is what the sliding window relies on.
+ */
+class Welford {
+public:
+  Welford() { reset(); }
+
+  /* @brief Forgets all samples. */
+  void reset() {
+    count = 0;
+    mean = 0.0f;
+    squaredDistanceSum = 0.0f;
+  }
+
+  /*
+   * @brief Adds a sample.
+   * @param value The sample value.
+   */
+  void add(float value) {
+    ++count;
+    const float delta = value - mean;
+    mean += delta / count;
+    squaredDistanceSum += delta * (value - mean);
+  }
+
+  /*
+   * @brief Removes a previously added sample.
+   * @param value The sample value.
+   */
+  void remove(float value) {
+    if (count <= 1) {
+      reset();
+      return;
+    }
+    const float delta = value - mean;
+    mean -= delta / (count - 1);
+    squaredDistanceSum -= delta * (value - mean);
+    --count;
+    // Guard against rounding pushing the sum below zero.
+    if (squaredDistanceSum < 0.0f) {
+      squaredDistanceSum = 0.0f;
+    }
+  }
+
+  uint32_t getCount() const { return count; }
+  float getMean() const { return mean; }
+
+  /* @return float The sample variance. Zero when less than two samples. */
+  float getVariance() const {
+    return count > 1 ? squaredDistanceSum / (count - 1) : 0.0f;
+  }
+
+private:
+  uint32_t count;           // Amount of samples.
+  float mean;               // Mean of the samples.
+  float squaredDistanceSum; // Sum of squared distances from the mean.
+};
+
+/*
+ * @brief Exponentially weighted moving average.
+ */
+class Ewma {
+public:
+  /*
+   * @brief Ewma class constructor.
+   * @param smoothing Weight of a new sample, between 0 and 1.
+   */
+  Ewma(float smoothing) : smoothing(smoothing), value(0.0f), empty(true) {}
+
+  /* @brief Forgets all samples. */
+  void reset() {
+    value = 0.0f;
+    empty = true;
+  }
+
+  /*
+   * @brief Adds a sample.
+   * @param sample The sample value.
+   */
+  void add(float sample) {
+    if (empty) {
+      value = sample;
+      empty = false;
+    } else {
+      value += smoothing * (sample - value);
+    }
+  }
+
+  float getValue() const { return value; }
+
+private:
+  float smoothing; // Weight of a new sample.
+  float value;     // The current average.
+  bool empty;      // True until the first sample is added.
+};
+
+/*
+ * @brief Approximate quantile estimator using the P-square algorithm by Jain
+ * and Chlamtac. Tracks five markers, so it runs in constant time and memory
+ * per sample.
+ */
+class P2Quantile {
+public:
+  /*
+   * @brief P2Quantile class constructor.
+   * @param quantile The quantile to estimate, between 0 and 1.
+   */
+  P2Quantile(float quantile) : quantile(quantile) {
+    increments[0] = 0.0f;
+    increments[1] = quantile / 2.0f;
+    increments[2] = quantile;
+    increments[3] = (1.0f + quantile) / 2.0f;
+    increments[4] = 1.0f;
+    reset();
+  }
+
+  /* @brief Forgets all samples. */
+  void reset() {
+    count = 0;
+    for (int i = 0; i < 5; ++i) {
+      positions[i] = i;
+    }
+    desiredPositions[0] = 0.0f;
+    desiredPositions[1] = 2.0f * quantile;
+    desiredPositions[2] = 4.0f * quantile;
+    desiredPositions[3] = 2.0f + 2.0f * quantile;
+    desiredPositions[4] = 4.0f;
+  }
+
+  /*
+   * @brief Adds a sample.
+   * @param value The sample value.
+   */
+  void add(float value) {
+    // The first five samples initialize the markers.
+    if (count < 5) {
+      heights[count] = value;
+      ++count;
+      // Keep the initial markers sorted (insertion sort).
+      for (int i = count - 1; i > 0 && heights[i] < heights[i - 1]; --i) {
+        const float swap = heights[i];
+        heights[i] = heights[i - 1];
+        heights[i - 1] = swap;
+      }
+      return;
+    }
+    ++count;
+
+    // Find the cell the sample falls into, extending the extremes if needed.
+    int cell;
+    if (value < heights[0]) {
+      heights[0] = value;
+      cell = 0;
+    } else if (value >= heights[4]) {
+      heights[4] = value;
+      cell = 3;
+    } else {
+      cell = 0;
+      while (value >= heights[cell + 1]) {
+        ++cell;
+      }
+    }
+
+    for (int i = cell + 1; i < 5; ++i) {
+      ++positions[i];
+    }
+    for (int i = 0; i < 5; ++i) {
+      desiredPositions[i] += increments[i];
+    }
+
+    // Adjust the heights of the three middle markers.
+    for (int i = 1; i < 4; ++i) {
+      const float offset = desiredPositions[i] - positions[i];
+      if ((offset >= 1.0f && positions[i + 1] - positions[i] > 1) ||
+          (offset <= -1.0f && positions[i - 1] - positions[i] < -1)) {
+        const int direction = offset > 0.0f ? 1 : -1;
+        const float parabolic = parabolicHeight(i, direction);
+        if (heights[i - 1] < parabolic && parabolic < heights[i + 1]) {
+          heights[i] = parabolic;
+        } else {
+          heights[i] += direction *
+                        (heights[i + direction] - heights[i]) /
+                        (positions[i + direction] - positions[i]);
+        }
+        positions[i] += direction;
+      }
+    }
+  }
+
+  /* @return float The estimated quantile. Zero when there are no samples. */
+  float getValue() const {
+    if (count == 0) {
+      return 0.0f;
+    }
+    if (count < 5) {
+      // The initial markers are the sorted samples themselves.
+      return heights[int(quantile * (count - 1) + 0.5f)];
+    }
+    return heights[2];
+  }
+
+  uint32_t getCount() const { return count; }
+
+private:
+  float quantile;            // The quantile to estimate.
+  uint32_t count;            // Amount of samples.
+  float heights[5];          // Marker heights.
+  int32_t positions[5];      // Actual marker positions.
+  float desiredPositions[5]; // Desired marker positions.
+  float increments[5];       // Desired position increment per sample.
+
+  /* @brief Piecewise-parabolic prediction of a marker's new height. */
+  float parabolicHeight(int i, int direction) const {
+    const float d = direction;
+    const float below = positions[i] - positions[i - 1];
+    const float above = positions[i + 1] - positions[i];
+    return heights[i] +
+           d / (positions[i + 1] - positions[i - 1]) *
+               ((below + d) * (heights[i + 1] - heights[i]) / above +
+                (above - d) * (heights[i] - heights[i - 1]) / below);
+  }
+};
+
+/*
+ * @brief Single-producer publication slot (a sequence lock).
+ * The producer never blocks. Readers retry if they raced with a publication.
+ */
+template <typename T> class Snapshot {
+public:
+  Snapshot() : sequence(0) {}
+
+  /*
+   * @brief Publishes a new value. Must only be called from one thread.
+   * @param value The value to publish.
+   */
+  void publish(const T &value) {
+    const uint32_t start = sequence.load(std::memory_order_relaxed);
+    sequence.store(start + 1, std::memory_order_relaxed); // Odd: writing.
+    std::atomic_thread_fence(std::memory_order_release);
+    data = value;
+    sequence.store(start + 2, std::memory_order_release); // Even: stable.
+  }
+
+  /* @return T A consistent copy of the latest published value. */
+  T read() const {
+    T copy;
+    uint32_t before;
+    uint32_t after;
+    do {
+      before = sequence.load(std::memory_order_acquire);
+      copy = data;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      after = sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+    return copy;
+  }
+
+private:
+  std::atomic<uint32_t> sequence; // Odd while a publication is in progress.
+  T data;                         // The published value.
+};
+
+/*
+ * @brief Statistics of a window of samples, as published to readers.
+ */
+struct StatisticsSnapshot {
+  uint32_t count;     // Amount of samples in the window.
+  float mean;         // Mean of the window.
+  float variance;     // Sample variance of the window.
+  float minimum;      // Smallest sample of the window.
+  float maximum;      // Largest sample of the window.
+  float ewma;         // Exponentially weighted moving average of all samples.
+  float rateOfChange; // Average change per sample over the window.
+  float median;       // Approximate median.
+  float percentile90; // Approximate 90th percentile.
+};
+
+/*
+ * @brief Statistics over the N most recent samples.
+ * Every operation is constant time per sample (the minimum, maximum and
+ * variance amortized), and memory is bounded by N. The percentiles are estimated over
+ * the most recent N/2 to N samples, by two estimators restarted in turn.
+ */
+template <int N> class SlidingWindowStatistics {
+public:
+  /*
+   * @brief SlidingWindowStatistics class constructor.
+   * @param smoothing Weight of a new sample in the EWMA.
+   */
+  SlidingWindowStatistics(float smoothing = 0.1f)
+      : ewma(smoothing), medians{P2Quantile(0.5f), P2Quantile(0.5f)},
+        percentiles90{P2Quantile(0.9f), P2Quantile(0.9f)} {
+    static_assert(N >= 2, "The window must hold at least two samples");
+    reset();
+  }
+
+  /* @brief Forgets all samples. Must be called from the producer thread. */
+  void reset() {
+    head = 0;
+    count = 0;
+    sampleNumber = 0;
+    minimaFront = 0;
+    minimaCount = 0;
+    maximaFront = 0;
+    maximaCount = 0;
+    welford.reset();
+    ewma.reset();
+    for (int i = 0; i < 2; ++i) {
+      medians[i].reset();
+      percentiles90[i].reset();
+    }
+    publish();
+  }
+
+  /*
+   * @brief Adds a sample, evicting the oldest one when the window is full.
+   * Must only be called from one (producer) thread.
+   * @param value The sample value.
+   */
+  void add(float value) {
+    if (count == N) {
+      welford.remove(samples[head]);
+    } else {
+      ++count;
+    }
+    samples[head] = value;
+    head = (head + 1) % N;
+    if (head == 0 && count == N) {
+      // Removing samples in float lets rounding errors add up over a long
+      // uptime. Start over from the window once per lap, amortized O(1).
+      welford.reset();
+      for (int i = 0; i < N; ++i) {
+        welford.add(samples[i]);
+      }
+    } else {
+      welford.add(value);
+    }
+    ewma.add(value);
+
+    pushExtrema(value);
+
+    // Restart the estimators in turn, half a window apart.
+    for (int i = 0; i < 2; ++i) {
+      if ((sampleNumber + i * (N / 2)) % N == 0) {
+        medians[i].reset();
+        percentiles90[i].reset();
+      }
+      medians[i].add(value);
+      percentiles90[i].add(value);
+    }
+    ++sampleNumber;
+
+    publish();
+  }
+
+  /* @return StatisticsSnapshot The latest statistics. Safe from any thread. */
+  StatisticsSnapshot read() const { return snapshot.read(); }
+
+private:
+  float samples[N];       // Ring buffer of the samples in the window.
+  int head;               // Index the next sample is written to.
+  int count;              // Amount of samples in the window.
+  uint32_t sampleNumber;  // Sequence number of the next sample.
+  Welford welford;        // Mean and variance of the window.
+  Ewma ewma;              // Average of all samples.
+  P2Quantile medians[2];  // Median estimators, restarted in turn.
+  P2Quantile percentiles90[2]; // 90th percentile estimators.
+
+  // Monotonic queues (ring buffers) of the window's minimum and maximum
+  // candidates, with the sample number of every candidate.
+  float minima[N];
+  uint32_t minimaNumbers[N];
+  int minimaFront;
+  int minimaCount;
+  float maxima[N];
+  uint32_t maximaNumbers[N];
+  int maximaFront;
+  int maximaCount;
+
+  Snapshot<StatisticsSnapshot> snapshot; // Published statistics.
+
+  /* @brief Updates the monotonic queues with a new sample. */
+  void pushExtrema(float value) {
+    const uint32_t oldestNumber = sampleNumber + 1 - count;
+
+    // Drop candidates that fell out of the window.
+    if (minimaCount > 0 && minimaNumbers[minimaFront] < oldestNumber) {
+      minimaFront = (minimaFront + 1) % N;
+      --minimaCount;
+    }
+    if (maximaCount > 0 && maximaNumbers[maximaFront] < oldestNumber) {
+      maximaFront = (maximaFront + 1) % N;
+      --maximaCount;
+    }
+
+    // Drop candidates the new sample makes irrelevant.
+    while (minimaCount > 0 &&
+           minima[(minimaFront + minimaCount - 1) % N] >= value) {
+      --minimaCount;
+    }
+    while (maximaCount > 0 &&
+           maxima[(maximaFront + maximaCount - 1) % N] <= value) {
+      --maximaCount;
+    }
+
+    const int minimaBack = (minimaFront + minimaCount) % N;
+    minima[minimaBack] = value;
+    minimaNumbers[minimaBack] = sampleNumber;
+    ++minimaCount;
+
+    const int maximaBack = (maximaFront + maximaCount) % N;
+    maxima[maximaBack] = value;
+    maximaNumbers[maximaBack] = sampleNumber;
+    ++maximaCount;
+  }
+
+  /* @brief Publishes the current statistics to readers. */
+  void publish() {
+    StatisticsSnapshot statistics;
+    statistics.count = count;
+    statistics.mean = welford.getMean();
+    statistics.variance = welford.getVariance();
+    statistics.ewma = ewma.getValue();
+    if (count > 0) {
+      statistics.minimum = minima[minimaFront];
+      statistics.maximum = maxima[maximaFront];
+      const float newest = samples[(head + N - 1) % N];
+      const float oldest = samples[(head + N - count) % N];
+      statistics.rateOfChange =
+          count > 1 ? (newest - oldest) / (count - 1) : 0.0f;
+    } else {
+      statistics.minimum = 0.0f;
+      statistics.maximum = 0.0f;
+      statistics.rateOfChange = 0.0f;
+    }
+    // Report the estimator that has seen the most samples.
+    const int estimator =
+        medians[0].getCount() >= medians[1].getCount() ? 0 : 1;
+    statistics.median = medians[estimator].getValue();
+    statistics.percentile90 = percentiles90[estimator].getValue();
+    snapshot.publish(statistics);
+  }
+};
+
+/*
+ * @brief Statistics over consecutive, non-overlapping windows of N samples.
+ * Readers see the statistics of the last completed window. Uses constant
+ * memory regardless of N.
+ */
+template <int N> class TumblingWindowStatistics {
+public:
+  /*
+   * @brief TumblingWindowStatistics class constructor.
+   * @param smoothing Weight of a new sample in the EWMA.
+   */
+  TumblingWindowStatistics(float smoothing = 0.1f)
+      : ewma(smoothing), median(0.5f), percentile90(0.9f) {
+    static_assert(N >= 1, "The window must hold at least one sample");
+    StatisticsSnapshot empty = {};
+    snapshot.publish(empty);
+    startWindow();
+  }
+
+  /*
+   * @brief Adds a sample, publishing the statistics when the window is full.
+   * Must only be called from one (producer) thread.
+   * @param value The sample value.
+   */
+  void add(float value) {
+    if (welford.getCount() == 0) {
+      first = value;
+      minimum = value;
+      maximum = value;
+    } else if (value < minimum) {
+      minimum = value;
+    } else if (value > maximum) {
+      maximum = value;
+    }
+    last = value;
+    welford.add(value);
+    ewma.add(value);
+    median.add(value);
+    percentile90.add(value);
+
+    if (welford.getCount() == N) {
+      publish();
+      startWindow();
+    }
+  }
+
+  /* @return StatisticsSnapshot The last completed window. Safe from any
+   * thread. */
+  StatisticsSnapshot read() const { return snapshot.read(); }
+
+private:
+  Welford welford;         // Mean and variance of the current window.
+  Ewma ewma;               // Average of all samples.
+  P2Quantile median;       // Median estimator of the current window.
+  P2Quantile percentile90; // 90th percentile estimator.
+  float first;             // First sample of the current window.
+  float last;              // Last sample of the current window.
+  float minimum;           // Smallest sample of the current window.
+  float maximum;           // Largest sample of the current window.
+
+  Snapshot<StatisticsSnapshot> snapshot; // Published statistics.
+
+  /* @brief Starts a new, empty window. */
+  void startWindow() {
+    welford.reset();
+    median.reset();
+    percentile90.reset();
+  }
+
+  /* @brief Publishes the statistics of the completed window to readers. */
+  void publish() {
+    StatisticsSnapshot statistics;
+    statistics.count = welford.getCount();
+    statistics.mean = welford.getMean();
+    statistics.variance = welford.getVariance();
+    statistics.minimum = minimum;
+    statistics.maximum = maximum;
+    statistics.ewma = ewma.getValue();
+    statistics.rateOfChange = N > 1 ? (last - first) / (N - 1) : 0.0f;
+    statistics.median = median.getValue();
+    statistics.percentile90 = percentile90.getValue();
+    snapshot.publish(statistics);
+  }
+};
+} // namespace kwin
+
+#endif
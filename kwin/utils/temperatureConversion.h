@@ -5,13 +5,30 @@
 #ifndef KWIN_UTILS_TEMPORATURE_CONVERSION
 #define KWIN_UTILS_TEMPORATURE_CONVERSION
 
+#include <stddef.h>
+#include <type_traits>
+
+namespace kwin {
+
+/*
+ * @brief The type temperatures of type T are converted in: T itself for
+ * floating point types, so float conversions stay in single precision, and
+ * double for integer types, whose results are truncated once, at the end.
+ */
+template <typename T> struct TemperatureArithmetic {
+  typedef typename std::conditional<std::is_floating_point<T>::value, T,
+                                    double>::type Type;
+};
+} // namespace kwin
+
 /*
  * @brief Converts from kelvin to celsius.
  * @param degrees Degrees in kelvin.
  * @return Degrees in celcius.
  */
 template <typename T> T convertKelvinToCelsius(T degrees) {
-  return degrees - 273.15;
+  typedef typename kwin::TemperatureArithmetic<T>::Type A;
+  return T(A(degrees) - A(273.15));
 }
 
 /*
@@ -20,7 +37,8 @@ template <typename T> T convertKelvinToCelsius(T degrees) {
  * @return Degrees in fahrenheit.
  */
 template <typename T> T convertKelvinToFahrenheit(T degrees) {
-  return (degrees - 273.15) * 1.8 + 32;
+  typedef typename kwin::TemperatureArithmetic<T>::Type A;
+  return T((A(degrees) - A(273.15)) * A(1.8) + A(32));
 }
 
 /*
@@ -29,7 +47,8 @@ template <typename T> T convertKelvinToFahrenheit(T degrees) {
  * @return Degrees in celcius.
  */
 template <typename T> T convertFahrenheitToCelsius(T degrees) {
-  return (degrees - 32) / 1.8;
+  typedef typename kwin::TemperatureArithmetic<T>::Type A;
+  return T((A(degrees) - A(32)) * A(5.0 / 9.0));
 }
 
 /*
@@ -38,7 +57,8 @@ template <typename T> T convertFahrenheitToCelsius(T degrees) {
  * @return Degrees in kelvin.
  */
 template <typename T> T convertFahrenheitToKelvin(T degrees) {
-  return (degrees - 32) / 1.8 + 273.15;
+  typedef typename kwin::TemperatureArithmetic<T>::Type A;
+  return T((A(degrees) - A(32)) * A(5.0 / 9.0) + A(273.15));
 }
 
 /*
@@ -47,7 +67,8 @@ template <typename T> T convertFahrenheitToKelvin(T degrees) {
  * @return Degrees in kelvin.
  */
 template <typename T> T convertCelsiusToKelvin(T degrees) {
-  return degrees + 273.15;
+  typedef typename kwin::TemperatureArithmetic<T>::Type A;
+  return T(A(degrees) + A(273.15));
 }
 
 /*
@@ -56,7 +77,210 @@ template <typename T> T convertCelsiusToKelvin(T degrees) {
  * @return Degrees in fahrenheit.
  */
 template <typename T> T convertCelsiusToFahrenheit(T degrees) {
-  return degrees * 1.8 + 32;
+  typedef typename kwin::TemperatureArithmetic<T>::Type A;
+  return T(A(degrees) * A(1.8) + A(32));
+}
+
+namespace kwin {
+
+/* @brief Temperature units. */
+enum TemperatureUnit { UNIT_CELSIUS, UNIT_FAHRENHEIT, UNIT_KELVIN };
+
+/*
+ * @brief Conversion of the form value * scale + offset, which covers every
+ * conversion between temperature units. Converting with a precomputed
+ * LinearConversion is a single multiply-add.
+ */
+template <typename T> struct LinearConversion {
+  static_assert(std::is_floating_point<T>::value,
+                "Scales like 5/9 need a floating point type");
+
+  T scale;  // Factor applied first.
+  T offset; // Amount added after scaling.
+
+  /* @return LinearConversion A conversion leaving values unchanged. */
+  static LinearConversion identity() {
+    LinearConversion conversion = {T(1), T(0)};
+    return conversion;
+  }
+
+  /* @return T The converted value. */
+  T apply(T value) const { return value * scale + offset; }
+
+  /*
+   * @return T The converted difference between two values, e.g. a standard
+   * deviation or a rate of change, which the offset doesn't apply to.
+   */
+  T applyToDifference(T difference) const { return difference * scale; }
+
+  /* @return LinearConversion This conversion followed by 'next'. */
+  LinearConversion then(const LinearConversion &next) const {
+    LinearConversion conversion = {scale * next.scale,
+                                   offset * next.scale + next.offset};
+    return conversion;
+  }
+};
+
+/*
+ * @brief Gets the conversion between two temperature units.
+ * @param from The unit of the values to convert.
+ * @param to The unit to convert to.
+ * @return LinearConversion<T> The conversion.
+ */
+template <typename T>
+LinearConversion<T> getTemperatureConversion(TemperatureUnit from,
+                                             TemperatureUnit to) {
+  // Both conversions go through celsius.
+  LinearConversion<T> toCelsius = LinearConversion<T>::identity();
+  if (from == UNIT_FAHRENHEIT) {
+    toCelsius.scale = T(5.0 / 9.0);
+    toCelsius.offset = T(-32.0 * 5.0 / 9.0);
+  } else if (from == UNIT_KELVIN) {
+    toCelsius.offset = T(-273.15);
+  }
+
+  LinearConversion<T> fromCelsius = LinearConversion<T>::identity();
+  if (to == UNIT_FAHRENHEIT) {
+    fromCelsius.scale = T(1.8);
+    fromCelsius.offset = T(32);
+  } else if (to == UNIT_KELVIN) {
+    fromCelsius.offset = T(273.15);
+  }
+
+  return toCelsius.then(fromCelsius);
+}
+
+/*
+ * @brief Converts a buffer of temperatures in one pass. The loop is a single
+ * multiply-add per value, so the compiler can vectorize it.
+ * @param source The temperatures to convert.
+ * @param destination Output for the converted temperatures. May be 'source'.
+ * @param count Amount of temperatures.
+ * @param from The unit of 'source'.
+ * @param to The unit to convert to.
+ */
+template <typename T>
+void convertTemperatures(const T *source, T *destination, size_t count,
+                         TemperatureUnit from, TemperatureUnit to) {
+  const LinearConversion<T> conversion = getTemperatureConversion<T>(from, to);
+  const T scale = conversion.scale;
+  const T offset = conversion.offset;
+  for (size_t i = 0; i < count; ++i) {
+    destination[i] = source[i] * scale + offset;
+  }
 }
 
-#endif
\ No newline at end of file
+/*
+ * @brief Converts a buffer of temperatures in place.
+ * @param degrees The temperatures to convert.
+ * @param count Amount of temperatures.
+ * @param from The current unit of the temperatures.
+ * @param to The unit to convert to.
+ */
+template <typename T>
+void convertTemperatures(T *degrees, size_t count, TemperatureUnit from,
+                         TemperatureUnit to) {
+  convertTemperatures(degrees, degrees, count, from, to);
+}
+
+/*
+ * @brief Gets the symbol of a temperature unit.
+ * @param unit The unit.
+ * @return const char* "C", "F" or "K".
+ */
+inline const char *getTemperatureUnitSymbol(TemperatureUnit unit) {
+  switch (unit) {
+  case UNIT_FAHRENHEIT:
+    return "F";
+  case UNIT_KELVIN:
+    return "K";
+  default:
+    return "C";
+  }
+}
+
+/*
+ * @brief A temperature tagged with its unit.
+ *
+ *   #Funcional resume:
+ *   Temperatures are stored once, in the unit they were measured in, and are
+ *   only converted when read in another unit, e.g. when displayed. Switching
+ *   the displayed unit therefore never changes stored samples.
+ */
+template <typename T> class Temperature {
+public:
+  Temperature() : degrees(T(0)), unit(UNIT_CELSIUS) {}
+  Temperature(T degrees, TemperatureUnit unit)
+      : degrees(degrees), unit(unit) {}
+
+  /* @return T The temperature in 'targetUnit'. */
+  T in(TemperatureUnit targetUnit) const {
+    if (targetUnit == unit) {
+      return degrees;
+    }
+    return getTemperatureConversion<T>(unit, targetUnit).apply(degrees);
+  }
+
+  /* @return T The temperature in the unit it was stored in. */
+  T getRawValue() const { return degrees; }
+
+  /* @return TemperatureUnit The unit the temperature was stored in. */
+  TemperatureUnit getUnit() const { return unit; }
+
+private:
+  T degrees;            // The temperature as stored.
+  TemperatureUnit unit; // Unit of 'degrees'.
+};
+
+/*
+ * @brief A history of temperatures, all stored in the history's unit.
+ *
+ *   #Funcional resume:
+ *   Wraps a buffer of raw degrees, e.g. a kwin::RingBuffer, that only takes
+ *   Temperature values or degrees tagged with their unit, and converts them
+ *   into the history's unit as they are added. Readers get the samples
+ *   read-only, together with the unit they are in.
+ */
+template <typename T, typename Samples> class TemperatureHistory {
+public:
+  /* @param unit The unit the samples are stored in. */
+  explicit TemperatureHistory(TemperatureUnit unit) : unit(unit) {}
+
+  /* @brief Adds a temperature, converted into the history's unit. */
+  void push_back(const Temperature<T> &temperature) {
+    samples.push_back(temperature.in(unit));
+  }
+
+  /*
+   * @brief Adds temperatures in one pass, e.g. restored ones.
+   * @param degrees The temperatures, oldest first. Converted in place.
+   * @param count Amount of temperatures.
+   * @param from The unit of 'degrees'.
+   */
+  void append(T *degrees, size_t count, TemperatureUnit from) {
+    if (from != unit) {
+      convertTemperatures(degrees, count, from, unit);
+    }
+    for (size_t i = 0; i < count; ++i) {
+      samples.push_back(degrees[i]);
+    }
+  }
+
+  /* @return TemperatureUnit The unit the samples are stored in. */
+  TemperatureUnit getUnit() const { return unit; }
+
+  /* @return const Samples& The samples, in getUnit(). */
+  const Samples &getSamples() const { return samples; }
+
+  /* @return LinearConversion<T> Converts samples into 'targetUnit'. */
+  LinearConversion<T> getConversionTo(TemperatureUnit targetUnit) const {
+    return getTemperatureConversion<T>(unit, targetUnit);
+  }
+
+private:
+  const TemperatureUnit unit; // Unit of the samples.
+  Samples samples;            // The temperatures, in 'unit'.
+};
+} // namespace kwin
+
+#endif
@@ -0,0 +1,109 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#include <vector>
+
+#include "check.h"
+#include "kwin/utils/alarms.h"
+
+std::vector<kwin::AlarmEvent> events; // Events reported by the engine.
+
+void recordEvent(const kwin::AlarmEvent &event) { events.push_back(event); }
+
+/* @brief Alarms raise after their duration and clear with hysteresis. */
+void testRaiseAndClear() {
+  kwin::AlarmEngine<4, 2> engine;
+  engine.onAlarm = recordEvent;
+  engine.addRule({"Hot", 0, kwin::ALARM_ABOVE, 30.0f, 2.0f, 1000});
+  engine.compile();
+  events.clear();
+
+  engine.update(0, 31.0f, 0);
+  CHECK(events.empty()); // The condition must hold for a second first.
+  engine.update(0, 31.0f, 1000);
+  CHECK(events.size() == 1 && events[0].raised);
+  CHECK(engine.getActiveAlarmCount() == 1);
+
+  engine.update(0, 29.0f, 2000);
+  CHECK(events.size() == 1); // Within the hysteresis.
+  engine.update(0, 27.9f, 3000);
+  CHECK(events.size() == 2 && !events[1].raised);
+  CHECK(engine.getActiveAlarmCount() == 0);
+}
+
+/*
+ * @brief The banner's alarm: when the latest raised alarm clears while an
+ * older one is still active, the older one is reported.
+ */
+void testLatestActiveAlarm() {
+  kwin::AlarmEngine<4, 2> engine;
+  engine.addRule({"Hot", 0, kwin::ALARM_ABOVE, 30.0f, 1.0f, 0});
+  engine.addRule({"Dark", 1, kwin::ALARM_BELOW, 10.0f, 1.0f, 0});
+  engine.addRule({"Very hot", 0, kwin::ALARM_ABOVE, 40.0f, 1.0f, 0});
+  engine.compile();
+  CHECK(engine.getLatestActiveRuleIndex() == -1);
+
+  engine.update(0, 35.0f, 0);
+  CHECK(engine.getLatestActiveRuleIndex() == 0);
+  engine.update(1, 5.0f, 0);
+  CHECK(engine.getLatestActiveRuleIndex() == 1);
+  engine.update(0, 45.0f, 1000);
+  CHECK(engine.getLatestActiveRuleIndex() == 2);
+
+  // "Very hot" clears, "Hot" and "Dark" stay active.
+  engine.update(0, 35.0f, 2000);
+  CHECK(engine.getActiveAlarmCount() == 2);
+  CHECK(engine.getLatestActiveRuleIndex() == 1);
+
+  // "Dark" clears, only "Hot" is left.
+  engine.update(1, 20.0f, 2000);
+  CHECK(engine.getLatestActiveRuleIndex() == 0);
+
+  // "Hot" clears and is raised again, after "Dark".
+  engine.update(1, 5.0f, 3000);
+  engine.update(0, 20.0f, 3000);
+  engine.update(0, 35.0f, 4000);
+  CHECK(engine.getLatestActiveRuleIndex() == 0);
+
+  engine.update(0, 20.0f, 5000);
+  engine.update(1, 20.0f, 5000);
+  CHECK(engine.getActiveAlarmCount() == 0);
+  CHECK(engine.getLatestActiveRuleIndex() == -1);
+}
+
+/* @brief Rate rules compare the change per second between samples. */
+void testRateRules() {
+  kwin::AlarmEngine<4, 1> engine;
+  engine.onAlarm = recordEvent;
+  engine.addRule({"Heating fast", 0, kwin::ALARM_RISE_RATE, 0.5f, 0.2f, 0});
+  engine.addRule({"Cooling fast", 0, kwin::ALARM_FALL_RATE, 0.5f, 0.2f, 0});
+  engine.compile();
+  events.clear();
+
+  engine.update(0, 20.0f, 0);
+  engine.update(0, 21.0f, 1000); // +1 per second.
+  CHECK(events.size() == 1 && events[0].ruleIndex == 0 && events[0].raised);
+  CHECK_NEAR(events[0].value, 1.0, 1e-6);
+  engine.update(0, 21.0f, 2000); // Steady, clears.
+  CHECK(events.size() == 2 && !events[1].raised);
+  engine.update(0, 19.0f, 4000); // -1 per second.
+  CHECK(events.size() == 3 && events[2].ruleIndex == 1 && events[2].raised);
+}
+
+/* @brief Rules of unknown sensors and beyond the capacity are refused. */
+void testCapacity() {
+  kwin::AlarmEngine<1, 1> engine;
+  CHECK(!engine.addRule({"Unknown", 1, kwin::ALARM_ABOVE, 0.0f, 0.0f, 0}));
+  CHECK(engine.addRule({"First", 0, kwin::ALARM_ABOVE, 0.0f, 0.0f, 0}));
+  CHECK(!engine.addRule({"Second", 0, kwin::ALARM_ABOVE, 0.0f, 0.0f, 0}));
+  CHECK(engine.getRuleCount() == 1);
+}
+
+int main() {
+  testRaiseAndClear();
+  testLatestActiveAlarm();
+  testRateRules();
+  testCapacity();
+  return finishTests();
+}
@@ -0,0 +1,97 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#include "check.h"
+#include "kwin/controls/button.h"
+
+/* @brief Counts the events a button evokes. */
+struct EventCounts {
+  int pressed;
+  int held;
+  int released;
+  int notPressed;
+};
+
+EventCounts counts;
+
+void countPressed() { ++counts.pressed; }
+void countHeld() { ++counts.held; }
+void countReleased() { ++counts.released; }
+void countNotPressed() { ++counts.notPressed; }
+
+/*
+ * @brief Creates a button at (10, 10) of 100x50, counting its events.
+ * @param suppressSteadyStateEvents Passed on to the button.
+ */
+kwin::Button createButton(bool suppressSteadyStateEvents) {
+  counts = EventCounts();
+  kwin::Button button(10, 10, 100, 50);
+  button.suppressSteadyStateEvents = suppressSteadyStateEvents;
+  button.onPressed = countPressed;
+  button.onHeld = countHeld;
+  button.onReleased = countReleased;
+  button.onNotPressed = countNotPressed;
+  return button;
+}
+
+/* @brief Without suppression every update evokes one event. */
+void testSteadyStateEventsRepeat() {
+  kwin::Button button = createButton(false);
+  for (int i = 0; i < 3; ++i) {
+    button.update(0, 0, 0, 0, false);
+  }
+  CHECK(counts.notPressed == 3);
+
+  button.update(20, 20, 0, 0, true);
+  button.update(20, 20, 20, 20, true);
+  button.update(20, 20, 20, 20, true);
+  CHECK(counts.pressed == 1);
+  CHECK(counts.held == 2);
+  CHECK(button.isPressed());
+
+  button.update(0, 0, 20, 20, false);
+  CHECK(counts.released == 1);
+  CHECK(!button.isPressed());
+}
+
+/*
+ * @brief With suppression onNotPressed fires once per release, onHeld only
+ * when the cursor moved, and the transitions still fire every time.
+ */
+void testSteadyStateEventsSuppressed() {
+  kwin::Button button = createButton(true);
+  for (int i = 0; i < 3; ++i) {
+    button.update(0, 0, 0, 0, false);
+  }
+  CHECK(counts.notPressed == 1);
+
+  button.update(20, 20, 0, 0, true);
+  button.update(20, 20, 20, 20, true);
+  CHECK(counts.pressed == 1);
+  CHECK(counts.held == 0);
+  button.update(25, 20, 20, 20, true);
+  CHECK(counts.held == 1);
+
+  // The first update after the release evokes onReleased, the next one
+  // onNotPressed again, once.
+  button.update(0, 0, 25, 20, false);
+  CHECK(counts.released == 1);
+  CHECK(counts.notPressed == 1);
+  for (int i = 0; i < 3; ++i) {
+    button.update(0, 0, 0, 0, false);
+  }
+  CHECK(counts.notPressed == 2);
+
+  // A second press and release fire again.
+  button.update(20, 20, 0, 0, true);
+  button.update(0, 0, 20, 20, false);
+  CHECK(counts.pressed == 2);
+  CHECK(counts.released == 2);
+}
+
+int main() {
+  testSteadyStateEventsRepeat();
+  testSteadyStateEventsSuppressed();
+  return finishTests();
+}
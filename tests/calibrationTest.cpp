@@ -0,0 +1,145 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#include "LightSensor.h"
+#include "check.h"
+#include "kwin/utils/calibration.h"
+
+/*
+ * @brief Illuminance of the reference curve the lux table was built from: a
+ * GL5528 type photoresistor of 10 kOhm at 10 lux with gamma 0.7, above a
+ * 10 kOhm resistor to ground.
+ * @param fraction The ADC reading between 0 and 1.
+ * @return double The illuminance in lux.
+ */
+double exactLux(double fraction) {
+  return 10.0 * pow(fraction / (1.0 - fraction), 1.0 / 0.7);
+}
+
+LightSensor lightSensor;
+
+/* @return float The illuminance LightSensor reports for a raw reading. */
+float readLux(uint16_t raw) {
+  analogInMockValue() = raw;
+  return lightSensor.readLux();
+}
+
+/* @brief Worst relative error of the lux table over a range of readings. */
+struct Band {
+  double low;   // Lowest ADC fraction of the band.
+  double high;  // Highest ADC fraction of the band.
+  double limit; // Largest relative error allowed.
+  double worst; // Largest relative error measured.
+};
+
+/*
+ * @brief Compares the readings at the table entries, halfway between them,
+ * and every other reading, with the exact curve.
+ */
+void testLuxTable() {
+  // The curve steepens towards 0.99, where the 1/256 steps of the table
+  // can't follow it anymore. The last step before saturation at 0.99 is off
+  // by up to 12%, at about 7000 lux.
+  Band bands[] = {{0.01, 0.05, 0.015, 0},
+                  {0.05, 0.95, 0.005, 0},
+                  {0.95, 0.98, 0.015, 0},
+                  {0.98, 0.99, 0.12, 0}};
+  double worstDark = 0;
+  for (uint32_t raw = 0; raw <= 0xFFFF; ++raw) {
+    const double fraction = raw / 65535.0;
+    const double lux = readLux(raw);
+    if (fraction < 0.01) {
+      // Far below the light of a dark room, the absolute error is tiny.
+      worstDark = fmax(worstDark, fabs(lux - exactLux(fraction)));
+      continue;
+    }
+    const double error = fabs(lux / exactLux(fraction) - 1.0);
+    for (Band &band : bands) {
+      if (fraction >= band.low && fraction < band.high) {
+        band.worst = fmax(band.worst, error);
+      }
+    }
+  }
+
+  printf("Below 0.01: %.5f lux worst error\n", worstDark);
+  CHECK(worstDark < 0.005);
+  for (const Band &band : bands) {
+    printf("%.2f to %.2f: %.2f%% worst error\n", band.low, band.high,
+           100 * band.worst);
+    CHECK(band.worst < band.limit);
+  }
+
+  // The table entries and the points halfway between them, on their own.
+  double worstEntry = 0;
+  double worstMidpoint = 0;
+  for (uint32_t index = 13; index < 243; ++index) {
+    const uint16_t raw = index << 8;
+    worstEntry =
+        fmax(worstEntry, fabs(readLux(raw) / exactLux(raw / 65535.0) - 1));
+    worstMidpoint = fmax(worstMidpoint, fabs(readLux(raw + 128) /
+                                                 exactLux((raw + 128) /
+                                                          65535.0) -
+                                             1));
+  }
+  printf("0.05 to 0.95: %.2f%% at entries, %.2f%% between them\n",
+         100 * worstEntry, 100 * worstMidpoint);
+  CHECK(worstEntry < 0.005);
+  CHECK(worstMidpoint < 0.005);
+}
+
+/* @brief Both ends: darkness is 0 lux, and readings saturate past 0.99. */
+void testLuxEndpoints() {
+  CHECK(readLux(0) == 0.0f);
+  CHECK(readLux(0xFFFF) == 7094.0f);
+  CHECK(readLux(0xFE00) == 7094.0f);
+  CHECK_NEAR(readLux(0x8000), 10.0, 0.05); // 10 kOhm, half the supply.
+
+  // The readings between the entries never leave the range of the entries.
+  float previous = 0.0f;
+  bool monotonic = true;
+  for (uint32_t raw = 0; raw <= 0xFFFF; ++raw) {
+    const float lux = readLux(raw);
+    monotonic = monotonic && lux >= previous;
+    previous = lux;
+  }
+  CHECK(monotonic);
+}
+
+/* @brief Points exactly on the curve interpolate exactly. */
+void testCalibrationTable() {
+  static constexpr kwin::CalibrationPoint points[] = {
+      {0.0f, -40.0f}, {0.25f, 0.0f}, {1.0f, 120.0f}};
+  static constexpr kwin::CalibrationTable<4> table(points);
+  static_assert(table.getValue(0) == -40.0f, "Generated at compile time");
+  CHECK(table.getValue(4) == 0.0f);
+  CHECK(table.getValue(16) == 120.0f);
+  for (uint32_t raw = 0; raw <= 0xFFFF; raw += 0x111) {
+    const double fraction = raw / 65536.0;
+    const double expected =
+        fraction < 0.25 ? -40 + 160 * fraction : (fraction - 0.25) * 160;
+    CHECK_NEAR(table.lookup(raw), expected, 1e-3);
+  }
+}
+
+/* @brief Two point corrections pass through both points. */
+void testLinearCalibration() {
+  // A sensor reading 1.5 degrees high at 0 C and 0.5 degrees low at 40 C.
+  constexpr kwin::LinearConversion<float> correction =
+      kwin::makeLinearCalibration({1.5f, 0.0f}, {39.5f, 40.0f});
+  CHECK_NEAR(correction.apply(1.5f), 0.0, 1e-5);
+  CHECK_NEAR(correction.apply(39.5f), 40.0, 1e-5);
+  for (int i = -40; i <= 80; ++i) {
+    const double expected = (i - 1.5) * 40.0 / 38.0;
+    CHECK_NEAR(correction.apply(i), expected, 1e-4);
+  }
+  CHECK_NEAR(correction.applyToDifference(3.8f), 4.0, 1e-5);
+}
+
+int main() {
+  testLuxTable();
+  testLuxEndpoints();
+  testCalibrationTable();
+  testLinearCalibration();
+  return finishTests();
+}
@@ -0,0 +1,56 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#ifndef KWIN_TESTS_CHECK
+#define KWIN_TESTS_CHECK
+
+#include <math.h>
+#include <stdio.h>
+
+/*
+ * Minimal checks for the host tests. A failed check is reported and counted,
+ * and the test carries on. main returns finishTests().
+ */
+
+/* @return int& Amount of failed checks. */
+inline int &failedCheckCount() {
+  static int count = 0;
+  return count;
+}
+
+#define CHECK(condition)                                                       \
+  do {                                                                         \
+    if (!(condition)) {                                                        \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__,         \
+              #condition);                                                     \
+      ++failedCheckCount();                                                    \
+    }                                                                          \
+  } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance)                                \
+  do {                                                                         \
+    const double checkActual = (actual);                                       \
+    const double checkExpected = (expected);                                   \
+    if (!(fabs(checkActual - checkExpected) <= (tolerance))) {                 \
+      fprintf(stderr, "%s:%d: CHECK_NEAR(%s, %s) failed: %.9g vs %.9g\n",      \
+              __FILE__, __LINE__, #actual, #expected, checkActual,             \
+              checkExpected);                                                  \
+      ++failedCheckCount();                                                    \
+    }                                                                          \
+  } while (0)
+
+/*
+ * @brief Reports the result of the test.
+ * @return int Exit code of the test, 0 if every check passed.
+ */
+inline int finishTests() {
+  if (failedCheckCount() > 0) {
+    fprintf(stderr, "%d checks failed\n", failedCheckCount());
+    return 1;
+  }
+  printf("All checks passed\n");
+  return 0;
+}
+
+#endif
@@ -0,0 +1,87 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#include "check.h"
+#include "kwin/utils/delegate.h"
+
+typedef kwin::Delegate<int(int)> IntDelegate;
+
+int doubled(int value) { return value * 2; }
+
+/* @brief Counter whose member function is bound with fromMethod. */
+class Counter {
+public:
+  Counter() : total(0) {}
+
+  int add(int value) {
+    total += value;
+    return total;
+  }
+
+  int total; // Sum of the values added so far.
+};
+
+/* @brief An empty delegate, and one made from a NULL function pointer. */
+void testEmpty() {
+  IntDelegate empty;
+  CHECK(!empty);
+  CHECK(empty == nullptr);
+
+  IntDelegate fromNull((int (*)(int))NULL);
+  CHECK(!fromNull);
+}
+
+/* @brief A plain function pointer is called with the arguments. */
+void testFunctionPointer() {
+  IntDelegate delegate(doubled);
+  CHECK(delegate);
+  CHECK(delegate != nullptr);
+  CHECK(delegate(21) == 42);
+}
+
+/*
+ * @brief A lambda capturing as much as the inline storage holds keeps its
+ * captures, also in copies of the delegate.
+ */
+void testCapturingLambda() {
+  int calls = 0;
+  int offset = 10;
+  int factor = 3;
+  int *callsPointer = &calls;
+  int *offsetPointer = &offset;
+  int *factorPointer = &factor;
+  auto lambda = [callsPointer, offsetPointer, factorPointer](int value) {
+    ++*callsPointer;
+    return value * *factorPointer + *offsetPointer;
+  };
+  static_assert(sizeof(lambda) == IntDelegate::STORAGE_SIZE,
+                "The lambda should fill the inline storage");
+
+  IntDelegate delegate(lambda);
+  CHECK(delegate(2) == 16);
+
+  const IntDelegate copy = delegate;
+  offset = 0;
+  CHECK(copy(2) == 6);
+  CHECK(calls == 2);
+}
+
+/* @brief A member function is called on the bound object. */
+void testFromMethod() {
+  Counter counter;
+  IntDelegate delegate = IntDelegate::fromMethod<Counter, &Counter::add>(
+      &counter);
+  CHECK(delegate);
+  CHECK(delegate(5) == 5);
+  CHECK(delegate(7) == 12);
+  CHECK(counter.total == 12);
+}
+
+int main() {
+  testEmpty();
+  testFunctionPointer();
+  testCapturingLambda();
+  testFromMethod();
+  return finishTests();
+}
@@ -0,0 +1,317 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#include <random>
+#include <string.h>
+#include <vector>
+
+#include "check.h"
+#include "kwin/sensors/dhtDecoder.h"
+
+std::mt19937 generator(11);
+
+int randomInt(int low, int high) {
+  return std::uniform_int_distribution<int>(low, high)(generator);
+}
+
+/* @brief Pulse widths of a frame in microseconds, as ranges. */
+struct Timing {
+  int responseMin; // Response low and high pulses.
+  int responseMax;
+  int bitLowMin; // Low pulses starting the bits.
+  int bitLowMax;
+  int zeroMin; // High pulses of 0 bits.
+  int zeroMax;
+  int oneMin; // High pulses of 1 bits.
+  int oneMax;
+};
+
+// The datasheets' nominal widths.
+const Timing NOMINAL = {80, 80, 50, 50, 26, 26, 70, 70};
+// The datasheets' tolerances: 75-85 us response pulses, 48-55 us bit lows,
+// 22-30 us and 68-75 us bit highs.
+const Timing DATASHEET = {75, 85, 48, 55, 22, 30, 68, 75};
+
+/*
+ * @brief Builds the edges of a read as the sensor would send them. The
+ * traces are synthesized from the datasheet timing, not captured.
+ * @param bytes The five bytes to send, the last one being the checksum.
+ * @param startUs Timestamp of the host releasing the line.
+ * @param timing The pulse widths.
+ */
+std::vector<kwin::DhtEdge> makeFrame(const uint8_t bytes[5], uint32_t startUs,
+                                     const Timing &timing) {
+  std::vector<kwin::DhtEdge> edges;
+  uint32_t timeUs = startUs;
+  // The host releases the line, the sensor answers 20-40 us later.
+  edges.push_back({timeUs, true});
+  timeUs += randomInt(20, 40);
+  edges.push_back({timeUs, false});
+  timeUs += randomInt(timing.responseMin, timing.responseMax);
+  edges.push_back({timeUs, true});
+  timeUs += randomInt(timing.responseMin, timing.responseMax);
+  edges.push_back({timeUs, false});
+  for (int bit = 0; bit < 40; ++bit) {
+    timeUs += randomInt(timing.bitLowMin, timing.bitLowMax);
+    edges.push_back({timeUs, true});
+    const bool one = bytes[bit / 8] & (0x80 >> (bit % 8));
+    timeUs += one ? randomInt(timing.oneMin, timing.oneMax)
+                  : randomInt(timing.zeroMin, timing.zeroMax);
+    edges.push_back({timeUs, false});
+  }
+  // The sensor releases the line after a last low pulse.
+  timeUs += randomInt(timing.bitLowMin, timing.bitLowMax);
+  edges.push_back({timeUs, true});
+  return edges;
+}
+
+kwin::DhtStatus decode(const std::vector<kwin::DhtEdge> &edges,
+                       kwin::DhtModel model,
+                       kwin::DhtMeasurement *measurement) {
+  return kwin::DhtDecoder::decode(edges.data(), edges.size(), model,
+                                  measurement);
+}
+
+/* @brief The example frames of the datasheets decode to their values. */
+void testDatasheetFrames() {
+  kwin::DhtMeasurement measurement;
+
+  // AM2302: 65.2 %RH and 35.1 C.
+  const uint8_t dht22[5] = {0x02, 0x8C, 0x01, 0x5F, 0xEE};
+  CHECK(decode(makeFrame(dht22, 1000, NOMINAL), kwin::DHT_MODEL_DHT22,
+               &measurement) == kwin::DHT_COMPLETE);
+  CHECK_NEAR(measurement.humidity, 65.2, 1e-4);
+  CHECK_NEAR(measurement.temperature, 35.1, 1e-4);
+
+  // AM2302: -10.1 C, the sign in the high bit.
+  const uint8_t dht22Negative[5] = {0x02, 0x8C, 0x80, 0x65, 0x73};
+  CHECK(decode(makeFrame(dht22Negative, 1000, NOMINAL),
+               kwin::DHT_MODEL_DHT22, &measurement) == kwin::DHT_COMPLETE);
+  CHECK_NEAR(measurement.temperature, -10.1, 1e-4);
+
+  // DHT11: 53 %RH and 24.6 C.
+  const uint8_t dht11[5] = {0x35, 0x00, 0x18, 0x06, 0x53};
+  CHECK(decode(makeFrame(dht11, 1000, NOMINAL), kwin::DHT_MODEL_DHT11,
+               &measurement) == kwin::DHT_COMPLETE);
+  CHECK_NEAR(measurement.humidity, 53.0, 1e-4);
+  CHECK_NEAR(measurement.temperature, 24.6, 1e-4);
+
+  // DHT11: -3.2 C, the sign in the high bit of the tenths.
+  const uint8_t dht11Negative[5] = {0x35, 0x00, 0x03, 0x82, 0xBA};
+  CHECK(decode(makeFrame(dht11Negative, 1000, NOMINAL),
+               kwin::DHT_MODEL_DHT11, &measurement) == kwin::DHT_COMPLETE);
+  CHECK_NEAR(measurement.temperature, -3.2, 1e-4);
+}
+
+/* @brief Frames within the datasheet tolerances decode, across a wrap of
+ * the microsecond timer too. */
+void testJitteredFrames() {
+  int wrong = 0;
+  for (int i = 0; i < 10000; ++i) {
+    uint8_t bytes[5];
+    for (int b = 0; b < 4; ++b) {
+      bytes[b] = randomInt(0, 255);
+    }
+    bytes[4] = bytes[0] + bytes[1] + bytes[2] + bytes[3];
+    // Every tenth frame crosses the wrap of the timestamps.
+    const uint32_t startUs =
+        i % 10 == 0 ? 0xFFFFFFFF - randomInt(0, 5000) : generator();
+
+    kwin::DhtDecoder decoder(kwin::DHT_MODEL_DHT22);
+    decoder.reset();
+    for (const kwin::DhtEdge &edge : makeFrame(bytes, startUs, DATASHEET)) {
+      decoder.feedEdge(edge.rising, edge.timeUs);
+    }
+    wrong += decoder.finish() != kwin::DHT_COMPLETE ||
+             memcmp(decoder.getBytes(), bytes, 5) != 0;
+  }
+  CHECK(wrong == 0);
+}
+
+/* @brief Decoding stops at the first edge that doesn't fit the frame. */
+void testBrokenFrames() {
+  const uint8_t bytes[5] = {0x02, 0x8C, 0x01, 0x5F, 0xEE};
+  const std::vector<kwin::DhtEdge> frame = makeFrame(bytes, 1000, NOMINAL);
+  kwin::DhtMeasurement measurement;
+
+  // A flipped bit breaks the checksum.
+  for (int bit = 0; bit < 40; ++bit) {
+    uint8_t flipped[5];
+    memcpy(flipped, bytes, sizeof(flipped));
+    flipped[bit / 8] ^= 0x80 >> (bit % 8);
+    CHECK(decode(makeFrame(flipped, 1000, NOMINAL), kwin::DHT_MODEL_DHT22,
+                 &measurement) == kwin::DHT_ERROR_CHECKSUM);
+  }
+
+  // Any missing edge of the response or the bits.
+  for (int missing = 1; missing < 1 + kwin::DhtDecoder::FRAME_EDGE_COUNT;
+       ++missing) {
+    std::vector<kwin::DhtEdge> edges = frame;
+    edges.erase(edges.begin() + missing);
+    const kwin::DhtStatus status =
+        decode(edges, kwin::DHT_MODEL_DHT22, &measurement);
+    CHECK(status == kwin::DHT_ERROR_TIMING ||
+          status == kwin::DHT_ERROR_TIMEOUT);
+  }
+
+  // The sensor stopping early times out.
+  for (int length = 0; length < 1 + kwin::DhtDecoder::FRAME_EDGE_COUNT;
+       ++length) {
+    const std::vector<kwin::DhtEdge> edges(frame.begin(),
+                                           frame.begin() + length);
+    CHECK(decode(edges, kwin::DHT_MODEL_DHT22, &measurement) ==
+          kwin::DHT_ERROR_TIMEOUT);
+  }
+
+  // Pulses out of range: a stretched response and a short bit low.
+  std::vector<kwin::DhtEdge> edges = frame;
+  for (size_t i = 2; i < edges.size(); ++i) {
+    edges[i].timeUs += 100;
+  }
+  CHECK(decode(edges, kwin::DHT_MODEL_DHT22, &measurement) ==
+        kwin::DHT_ERROR_TIMING);
+  edges = frame;
+  for (size_t i = 10; i < edges.size(); ++i) {
+    edges[i].timeUs -= 40;
+  }
+  CHECK(decode(edges, kwin::DHT_MODEL_DHT22, &measurement) ==
+        kwin::DHT_ERROR_TIMING);
+}
+
+/*
+ * @brief Glitches, short spikes of the opposite level anywhere within the
+ * frame, fail the read instead of decoding wrong values. A spike cutting
+ * the last high pulse short only ends the frame early: a 0 bit still
+ * decodes, a 1 bit read as a 0 fails the checksum.
+ */
+void testGlitches() {
+  int decodedWrong = 0;
+  int failed = 0;
+  const int READS = 20000;
+  for (int i = 0; i < READS; ++i) {
+    uint8_t bytes[5];
+    for (int b = 0; b < 4; ++b) {
+      bytes[b] = randomInt(0, 255);
+    }
+    bytes[4] = bytes[0] + bytes[1] + bytes[2] + bytes[3];
+    std::vector<kwin::DhtEdge> edges =
+        makeFrame(bytes, generator(), DATASHEET);
+
+    // A spike of 1-8 us inside a pulse of the response or the bits.
+    const int pulse = randomInt(1, kwin::DhtDecoder::FRAME_EDGE_COUNT - 1);
+    const uint32_t pulseUs = edges[pulse + 1].timeUs - edges[pulse].timeUs;
+    const uint32_t spikeUs = randomInt(1, 8);
+    const uint32_t offsetUs = randomInt(1, pulseUs - spikeUs - 1);
+    const bool level = edges[pulse].rising;
+    const kwin::DhtEdge spike[2] = {
+        {edges[pulse].timeUs + offsetUs, !level},
+        {edges[pulse].timeUs + offsetUs + spikeUs, level}};
+    edges.insert(edges.begin() + pulse + 1, spike, spike + 2);
+
+    kwin::DhtDecoder decoder(kwin::DHT_MODEL_DHT22);
+    decoder.reset();
+    for (const kwin::DhtEdge &edge : edges) {
+      decoder.feedEdge(edge.rising, edge.timeUs);
+    }
+    const kwin::DhtStatus status = decoder.finish();
+    failed += status != kwin::DHT_COMPLETE ||
+              pulse == kwin::DhtDecoder::FRAME_EDGE_COUNT - 1;
+    decodedWrong += status == kwin::DHT_COMPLETE &&
+                    memcmp(decoder.getBytes(), bytes, 5) != 0;
+  }
+  CHECK(decodedWrong == 0);
+  CHECK(failed == READS);
+}
+
+/*
+ * @brief Randomly damaged frames and random edges never complete with a
+ * checksum that doesn't match.
+ */
+void testRandomTraces() {
+  int completed = 0;
+  int changed = 0;
+  int badChecksums = 0;
+  const int TRACES = 100000;
+  for (int i = 0; i < TRACES; ++i) {
+    uint8_t bytes[5];
+    for (int b = 0; b < 4; ++b) {
+      bytes[b] = randomInt(0, 255);
+    }
+    bytes[4] = bytes[0] + bytes[1] + bytes[2] + bytes[3];
+    std::vector<kwin::DhtEdge> edges;
+    if (i % 2) {
+      // A frame with a few edges moved, dropped or duplicated.
+      edges = makeFrame(bytes, generator(), DATASHEET);
+      const int damages = randomInt(1, 3);
+      for (int damage = 0; damage < damages; ++damage) {
+        const int edge = randomInt(1, edges.size() - 1);
+        switch (randomInt(0, 2)) {
+        case 0:
+          edges[edge].timeUs += randomInt(-30, 30);
+          break;
+        case 1:
+          edges.erase(edges.begin() + edge);
+          break;
+        default:
+          edges.insert(edges.begin() + edge, edges[edge]);
+          break;
+        }
+      }
+    } else {
+      // Random edges, mostly of plausible widths.
+      uint32_t timeUs = generator();
+      bool rising = randomInt(0, 1);
+      const int edgeCount = randomInt(0, 120);
+      for (int edge = 0; edge < edgeCount; ++edge) {
+        timeUs += randomInt(0, 3) ? randomInt(20, 85) : randomInt(0, 400);
+        edges.push_back({timeUs, rising});
+        rising = randomInt(0, 9) ? !rising : rising;
+      }
+    }
+
+    kwin::DhtDecoder decoder(kwin::DHT_MODEL_DHT22);
+    decoder.reset();
+    for (const kwin::DhtEdge &edge : edges) {
+      decoder.feedEdge(edge.rising, edge.timeUs);
+    }
+    if (decoder.finish() == kwin::DHT_COMPLETE) {
+      ++completed;
+      const uint8_t *b = decoder.getBytes();
+      badChecksums += (uint8_t)(b[0] + b[1] + b[2] + b[3]) != b[4];
+      changed += i % 2 && memcmp(b, bytes, 5) != 0;
+    }
+  }
+  printf("Random traces: %d of %d completed, %d damaged frames changed\n",
+         completed, TRACES, changed);
+  CHECK(badChecksums == 0);
+  // Most damage can't go unnoticed, only moves that keep every pulse in
+  // range and every bit on its side of the threshold.
+  CHECK(completed > 0 && completed < TRACES / 4);
+}
+
+/* @brief Reads before the first reset are idle, and edges after the frame
+ * are ignored. */
+void testStatus() {
+  kwin::DhtDecoder decoder;
+  CHECK(decoder.getStatus() == kwin::DHT_IDLE);
+  decoder.reset();
+  CHECK(decoder.getStatus() == kwin::DHT_DECODING);
+
+  const uint8_t bytes[5] = {0x02, 0x8C, 0x01, 0x5F, 0xEE};
+  for (const kwin::DhtEdge &edge : makeFrame(bytes, 1000, NOMINAL)) {
+    decoder.feedEdge(edge.rising, edge.timeUs);
+  }
+  CHECK(decoder.feedEdge(false, 9000000) == kwin::DHT_COMPLETE);
+  CHECK(decoder.finish() == kwin::DHT_COMPLETE);
+}
+
+int main() {
+  testDatasheetFrames();
+  testJitteredFrames();
+  testBrokenFrames();
+  testGlitches();
+  testRandomTraces();
+  testStatus();
+  return finishTests();
+}
@@ -0,0 +1,320 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#include <algorithm>
+#include <random>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "kwin/graphics/displayList.h"
+#include "lcdMock.h"
+
+const int WIDTH = RK043FN48H_WIDTH;
+const int HEIGHT = RK043FN48H_HEIGHT;
+
+/* @brief Something a frame draws, recorded as one or two commands. */
+struct Widget {
+  kwin::DrawCommandType type;
+  int x0;
+  int y0;
+  int x1;
+  int y1;
+  uint32_t color;
+  std::string text;
+  Text_AlignModeTypdef mode;
+};
+
+// A 24-bit BMP of 6x4 pixels, for bitmap widgets.
+uint8_t bitmap[54 + 6 * 4 * 3];
+
+void createBitmap() {
+  memset(bitmap, 0, sizeof(bitmap));
+  bitmap[0] = 'B';
+  bitmap[1] = 'M';
+  bitmap[10] = 54; // Offset of the pixels.
+  bitmap[18] = 6;  // Width.
+  bitmap[22] = 4;  // Height.
+  bitmap[28] = 24; // Bits per pixel.
+  for (int i = 54; i < (int)sizeof(bitmap); ++i) {
+    bitmap[i] = i * 37;
+  }
+}
+
+/* @brief Records a frame: a clear followed by the widgets. */
+void record(kwin::DisplayList &list, const std::vector<Widget> &widgets) {
+  list.clear(LCD_COLOR_BLACK);
+  list.setBackColor(LCD_COLOR_BLACK);
+  for (const Widget &widget : widgets) {
+    list.setTextColor(widget.color);
+    switch (widget.type) {
+    case kwin::DRAW_FILL_RECT:
+      list.fillRect(widget.x0, widget.y0, widget.x1, widget.y1);
+      break;
+    case kwin::DRAW_HLINE:
+      list.drawHLine(widget.x0, widget.y0, widget.x1);
+      break;
+    case kwin::DRAW_VLINE:
+      list.drawVLine(widget.x0, widget.y0, widget.y1);
+      break;
+    case kwin::DRAW_LINE:
+      list.drawLine(widget.x0, widget.y0, widget.x1, widget.y1);
+      break;
+    case kwin::DRAW_TEXT:
+      list.setFont(widget.x1 ? &Font12 : &Font16);
+      list.displayStringAt(widget.x0, widget.y0,
+                           (const uint8_t *)widget.text.c_str(), widget.mode);
+      break;
+    case kwin::DRAW_BITMAP:
+      list.drawBitmap(widget.x0, widget.y0, bitmap);
+      break;
+    }
+  }
+}
+
+/* @brief Draws a frame directly with the BSP, as record describes it. */
+void drawDirectly(const std::vector<Widget> &widgets) {
+  BSP_LCD_Clear(LCD_COLOR_BLACK);
+  BSP_LCD_SetBackColor(LCD_COLOR_BLACK);
+  for (const Widget &widget : widgets) {
+    BSP_LCD_SetTextColor(widget.color);
+    switch (widget.type) {
+    case kwin::DRAW_FILL_RECT:
+      BSP_LCD_FillRect(widget.x0, widget.y0, widget.x1, widget.y1);
+      break;
+    case kwin::DRAW_HLINE:
+      BSP_LCD_DrawHLine(widget.x0, widget.y0, widget.x1);
+      break;
+    case kwin::DRAW_VLINE:
+      BSP_LCD_DrawVLine(widget.x0, widget.y0, widget.y1);
+      break;
+    case kwin::DRAW_LINE:
+      BSP_LCD_DrawLine(widget.x0, widget.y0, widget.x1, widget.y1);
+      break;
+    case kwin::DRAW_TEXT:
+      BSP_LCD_SetFont(widget.x1 ? &Font12 : &Font16);
+      BSP_LCD_DisplayStringAt(widget.x0, widget.y0,
+                              (uint8_t *)widget.text.c_str(), widget.mode);
+      break;
+    case kwin::DRAW_BITMAP:
+      BSP_LCD_DrawBitmap(widget.x0, widget.y0, bitmap);
+      break;
+    }
+  }
+}
+
+std::mt19937 generator(7);
+
+int randomInt(int low, int high) {
+  return std::uniform_int_distribution<int>(low, high)(generator);
+}
+
+Widget randomWidget() {
+  const uint32_t colors[] = {LCD_COLOR_RED,    LCD_COLOR_GREEN,
+                             LCD_COLOR_BLUE,   LCD_COLOR_YELLOW,
+                             LCD_COLOR_CYAN,   LCD_COLOR_WHITE,
+                             LCD_COLOR_ORANGE, LCD_COLOR_DARKGRAY};
+  Widget widget;
+  widget.type = (kwin::DrawCommandType)randomInt(0, 5);
+  widget.x0 = randomInt(0, WIDTH - 1);
+  widget.y0 = randomInt(0, HEIGHT - 1);
+  widget.x1 = randomInt(0, WIDTH - 1);
+  widget.y1 = randomInt(0, HEIGHT - 1);
+  widget.color = colors[randomInt(0, 7)];
+  widget.mode = LEFT_MODE;
+  if (widget.type == kwin::DRAW_FILL_RECT) {
+    widget.x1 = randomInt(1, 80);
+    widget.y1 = randomInt(1, 60);
+  } else if (widget.type == kwin::DRAW_HLINE) {
+    widget.x1 = randomInt(1, WIDTH - widget.x0);
+  } else if (widget.type == kwin::DRAW_VLINE) {
+    widget.y1 = randomInt(1, HEIGHT - widget.y0);
+  } else if (widget.type == kwin::DRAW_LINE && randomInt(0, 2) == 0) {
+    widget.y1 = widget.y0; // Axis aligned lines are clipped.
+  } else if (widget.type == kwin::DRAW_TEXT) {
+    widget.x1 = randomInt(0, 1);
+    widget.y0 = randomInt(0, HEIGHT - 16);
+    widget.mode = (Text_AlignModeTypdef)randomInt(1, 3);
+    widget.text = "T" + std::to_string(randomInt(0, 99999));
+  } else if (widget.type == kwin::DRAW_BITMAP) {
+    widget.x0 = randomInt(0, WIDTH - 6);
+    widget.y0 = randomInt(0, HEIGHT - 4);
+  }
+  return widget;
+}
+
+std::vector<uint32_t> readFramebuffer() {
+  std::vector<uint32_t> pixels(WIDTH * HEIGHT);
+  for (int y = 0; y < HEIGHT; ++y) {
+    for (int x = 0; x < WIDTH; ++x) {
+      pixels[y * WIDTH + x] = lcdMockReadPixel(x, y);
+    }
+  }
+  return pixels;
+}
+
+kwin::RetainedDisplay incremental;
+
+/*
+ * @brief Draws a frame incrementally and compares the framebuffer with the
+ * same frame drawn directly with the BSP.
+ * @return int32_t Pixels repainted by the incremental frame.
+ */
+int32_t drawAndCompare(const std::vector<Widget> &widgets) {
+  record(incremental.beginFrame(), widgets);
+  incremental.endFrame();
+  const int32_t repaintedArea = incremental.getLastRepaintedArea();
+  const std::vector<uint32_t> incrementalPixels = readFramebuffer();
+
+  drawDirectly(widgets);
+  const std::vector<uint32_t> referencePixels = readFramebuffer();
+
+  int differences = 0;
+  for (size_t i = 0; i < referencePixels.size(); ++i) {
+    differences += incrementalPixels[i] != referencePixels[i];
+  }
+  CHECK(differences == 0);
+
+  // Continue from the incremental frame.
+  memcpy(lcdMockMemory, incrementalPixels.data(),
+         incrementalPixels.size() * sizeof(uint32_t));
+  return repaintedArea;
+}
+
+/*
+ * @brief Random frame sequences: widgets change, appear and disappear. Every
+ * incremental frame must match a full redraw pixel for pixel.
+ */
+void testMatchesFullRedraw() {
+  std::vector<Widget> widgets;
+  for (int i = 0; i < 60; ++i) {
+    widgets.push_back(randomWidget());
+  }
+  drawAndCompare(widgets);
+
+  int64_t repaintedArea = 0;
+  const int FRAMES = 300;
+  for (int frame = 0; frame < FRAMES; ++frame) {
+    const int changes = randomInt(0, 3);
+    for (int change = 0; change < changes; ++change) {
+      const int index = randomInt(0, widgets.size() - 1);
+      switch (randomInt(0, 4)) {
+      case 0: // Insert.
+        widgets.insert(widgets.begin() + index, randomWidget());
+        break;
+      case 1: // Remove.
+        if (widgets.size() > 10) {
+          widgets.erase(widgets.begin() + index);
+        }
+        break;
+      case 2: // Recolor.
+        widgets[index].color ^= 0x00FF00;
+        break;
+      case 3: // Move to the end, on top of everything.
+        widgets.push_back(widgets[index]);
+        widgets.erase(widgets.begin() + index);
+        break;
+      default: // Change the text or geometry.
+        widgets[index].text += "x";
+        widgets[index].y0 = std::min(widgets[index].y0 + 1, HEIGHT - 16);
+        break;
+      }
+    }
+    repaintedArea += drawAndCompare(widgets);
+  }
+  printf("Random frames: %.1f%% of the screen repainted on average\n",
+         100.0 * repaintedArea / FRAMES / (WIDTH * HEIGHT));
+}
+
+/*
+ * @brief An alarm banner inserted in front of an unchanged scene only
+ * repaints the banner, and so does removing it again.
+ */
+void testInsertedBanner() {
+  std::vector<Widget> scene;
+  for (int row = 0; row < 8; ++row) {
+    Widget line = {kwin::DRAW_HLINE, 0, 40 + row * 28, WIDTH, 1,
+                   LCD_COLOR_DARKGRAY, "", LEFT_MODE};
+    scene.push_back(line);
+    Widget label = {kwin::DRAW_TEXT, 4, 44 + row * 28, 1, 0,
+                    LCD_COLOR_WHITE, "Label " + std::to_string(row),
+                    LEFT_MODE};
+    scene.push_back(label);
+    Widget curve = {kwin::DRAW_LINE, 100, 50 + row * 28, 470, 60 + row * 28,
+                    LCD_COLOR_GREEN, "", LEFT_MODE};
+    scene.push_back(curve);
+  }
+  drawAndCompare(scene);
+  CHECK(drawAndCompare(scene) == 0);
+
+  std::vector<Widget> withBanner = scene;
+  const Widget bannerFill = {kwin::DRAW_FILL_RECT, 0, 0, WIDTH, 24,
+                             LCD_COLOR_RED, "", LEFT_MODE};
+  const Widget bannerText = {kwin::DRAW_TEXT, 0, 4, 0, 0, LCD_COLOR_WHITE,
+                             "ALARM: Too hot", CENTER_MODE};
+  withBanner.insert(withBanner.begin(), bannerText);
+  withBanner.insert(withBanner.begin(), bannerFill);
+
+  const int32_t bannerArea = WIDTH * 24;
+  CHECK(drawAndCompare(withBanner) == bannerArea);
+  CHECK(drawAndCompare(withBanner) == 0);
+  CHECK(drawAndCompare(scene) == bannerArea);
+
+  // Inserted in the middle of the scene.
+  withBanner = scene;
+  withBanner.insert(withBanner.begin() + 12, bannerText);
+  withBanner.insert(withBanner.begin() + 12, bannerFill);
+  CHECK(drawAndCompare(withBanner) == bannerArea);
+  CHECK(drawAndCompare(scene) == bannerArea);
+}
+
+/*
+ * @brief Frames overflowing the list, by commands or by text, are redrawn
+ * completely, without losing the commands past the capacity, such as a
+ * banner drawn last.
+ */
+void testOverflow() {
+  const Widget bannerFill = {kwin::DRAW_FILL_RECT, 0, 0, WIDTH, 24,
+                             LCD_COLOR_RED, "", LEFT_MODE};
+  const Widget bannerText = {kwin::DRAW_TEXT, 0, 4, 0, 0, LCD_COLOR_WHITE,
+                             "ALARM: Too hot", CENTER_MODE};
+
+  std::vector<Widget> widgets;
+  for (int i = 0; i < 2 * KWIN_DISPLAY_LIST_MAX_COMMANDS + 10; ++i) {
+    widgets.push_back(randomWidget());
+  }
+  widgets.push_back(bannerFill);
+  widgets.push_back(bannerText);
+  CHECK(drawAndCompare(widgets) == WIDTH * HEIGHT);
+  CHECK(lcdMockReadPixel(0, 0) == LCD_COLOR_RED);
+
+  std::vector<Widget> texts;
+  const int textBytes = 40;
+  for (int i = 0; i < 2 * KWIN_DISPLAY_LIST_MAX_TEXT_BYTES / textBytes; ++i) {
+    Widget text = {kwin::DRAW_TEXT, 0, (i * 12) % (HEIGHT - 16), 1, 0,
+                   LCD_COLOR_GREEN, std::string(textBytes - 1, 'a' + i % 26),
+                   LEFT_MODE};
+    texts.push_back(text);
+  }
+  texts.push_back(bannerFill);
+  texts.push_back(bannerText);
+  CHECK(drawAndCompare(texts) == WIDTH * HEIGHT);
+
+  // The frame after an overflowing one is drawn completely too.
+  widgets.resize(40);
+  CHECK(drawAndCompare(widgets) == WIDTH * HEIGHT);
+  drawAndCompare(widgets);
+}
+
+int main() {
+  BSP_LCD_Init();
+  BSP_LCD_LayerDefaultInit(LTDC_ACTIVE_LAYER, LCD_FB_START_ADDRESS);
+  createBitmap();
+
+  testMatchesFullRedraw();
+  testInsertedBanner();
+  testOverflow();
+  return finishTests();
+}
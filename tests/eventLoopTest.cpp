@@ -0,0 +1,107 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#include "check.h"
+#include "kwin/utils/eventLoop.h"
+
+/* @brief VirtualClock counting how often the loop idles. */
+class CountingClock : public kwin::VirtualClock {
+public:
+  CountingClock() : waitCount(0) {}
+
+  void waitUntil(uint32_t deadlineUs) {
+    ++waitCount;
+    kwin::VirtualClock::waitUntil(deadlineUs);
+  }
+
+  int waitCount; // Calls to waitUntil.
+};
+
+CountingClock clock;
+
+// Handlers of the idle UI, costing what the graph demo costs when nothing
+// changes: the frame is recorded and diffed, but nothing is drawn.
+void renderUnchangedFrame() { clock.advance(50); }
+void pollSerialInput() { clock.advance(2); }
+void report() { clock.advance(500); }
+
+/*
+ * @brief An idle UI: the loop sleeps between its timers, without polling,
+ * and the accounting reports the handlers' cost.
+ */
+void testIdleUi() {
+  kwin::EventLoop<4> loop(clock);
+  const int frame = loop.addTimer("frame", 100000, renderUnchangedFrame);
+  const int input = loop.addTimer("input", 100000, pollSerialInput);
+  loop.addTimer("report", 10000000, report);
+  loop.resetAccounting();
+
+  const uint32_t startUs = clock.nowUs();
+  clock.waitCount = 0;
+  while (clock.nowUs() - startUs < 60000000) {
+    loop.runOnce();
+  }
+
+  const float idle = loop.getIdlePercentage();
+  printf("Idle UI: %.3f%% idle, %d wakeups in 60 s\n", idle, clock.waitCount);
+  // 52 us every 100 ms and 0.5 ms every 10 s.
+  CHECK_NEAR(idle, 100.0 - 0.052 - 0.005, 0.001);
+  CHECK_NEAR(loop.getTaskStatistics(frame).utilization, 0.05, 0.001);
+  // The loop stops as the 600th frame is due.
+  CHECK(loop.getTaskStatistics(frame).runCount == 599);
+  CHECK(loop.getTaskStatistics(input).runCount == 599);
+  // The frame and input timers share their deadlines, so the loop wakes ten
+  // times a second, plus for the reports.
+  CHECK(clock.waitCount <= 600 + 6 + 1);
+}
+
+int handledEvents = 0;
+void handleEvent() { ++handledEvents; }
+
+/* @brief A post wakes the idling loop, and repeated posts coalesce. */
+void testPostWakes() {
+  kwin::EventLoop<2> loop(clock);
+  const int event = loop.addEvent("event", handleEvent);
+  handledEvents = 0;
+
+  // Without timers the loop idles for a second at most.
+  uint32_t before = clock.nowUs();
+  loop.runOnce();
+  CHECK(clock.nowUs() - before == 1000000);
+
+  // Posted from elsewhere while busy: the wait returns at once.
+  loop.post(event);
+  loop.post(event);
+  before = clock.nowUs();
+  loop.runOnce();
+  CHECK(handledEvents == 1);
+  CHECK(clock.nowUs() == before);
+  loop.runOnce();
+  CHECK(handledEvents == 1);
+}
+
+void slowFrame() { clock.advance(350000); }
+
+/* @brief A task overrunning its period skips the missed runs. */
+void testOverrunSkips() {
+  kwin::EventLoop<1> loop(clock);
+  const int frame = loop.addTimer("frame", 100000, slowFrame);
+  loop.resetAccounting();
+
+  const uint32_t startUs = clock.nowUs();
+  while (clock.nowUs() - startUs < 10000000) {
+    loop.runOnce();
+  }
+  // Back to back runs of 350 ms, not a burst catching up on 100 ms periods.
+  const uint32_t runCount = loop.getTaskStatistics(frame).runCount;
+  CHECK(runCount == 29);
+  CHECK(loop.getIdlePercentage() < 2.0f);
+}
+
+int main() {
+  testIdleUi();
+  testPostWakes();
+  testOverrunSkips();
+  return finishTests();
+}
@@ -0,0 +1,60 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#include "check.h"
+#include "kwin/utils/memoryPool.h"
+
+struct alignas(8) Wide {
+  double value;
+  char tag;
+};
+
+struct Narrow {
+  char tag[3];
+};
+
+/* @brief An arena sized with arenaBytesFor fits its objects in any order. */
+void testArenaBytesFor() {
+  static_assert(kwin::arenaBytesFor<Wide>(3) == 3 * sizeof(Wide) + 7,
+                "Padding of the first object");
+  static_assert(kwin::arenaBytesFor<Narrow>() == sizeof(Narrow),
+                "Byte aligned objects need no padding");
+
+  // The narrow objects leave the wide ones misaligned.
+  kwin::Arena<kwin::arenaBytesFor<Narrow>(1) + kwin::arenaBytesFor<Wide>(3)>
+      arena;
+  CHECK(arena.create<Narrow>() != NULL);
+  for (int i = 0; i < 3; ++i) {
+    Wide *wide = arena.create<Wide>();
+    CHECK(wide != NULL);
+    CHECK(reinterpret_cast<uintptr_t>(wide) % alignof(Wide) == 0);
+  }
+  CHECK(arena.getStatistics().failedAllocations == 0);
+
+  // Anything more does not fit.
+  CHECK(arena.create<Wide>() == NULL);
+  CHECK(arena.getStatistics().failedAllocations == 1);
+}
+
+/* @brief Pools hand out and take back their blocks. */
+void testObjectPool() {
+  kwin::ObjectPool<Wide, 2> pool;
+  Wide *first = pool.create();
+  Wide *second = pool.create();
+  CHECK(first != NULL && second != NULL && first != second);
+  CHECK(pool.create() == NULL);
+
+  pool.destroy(first);
+  CHECK(pool.create() == first);
+  const kwin::AllocatorStatistics statistics = pool.getStatistics();
+  CHECK(statistics.used == 2);
+  CHECK(statistics.highWaterMark == 2);
+  CHECK(statistics.failedAllocations == 1);
+}
+
+int main() {
+  testArenaBytesFor();
+  testObjectPool();
+  return finishTests();
+}
@@ -0,0 +1,127 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+// Host mock of kwin::DhtReader, found before the real one on the include
+// path of the tests that use it. Every read succeeds when its deadline
+// passes, which the test signals with dhtReaderMockFinishReads like the
+// reader's Timeout would.
+
+#ifndef KWIN_SENSORS_DHT_READER
+#define KWIN_SENSORS_DHT_READER
+
+#include <vector>
+
+#include "kwin/sensors/dhtDecoder.h"
+#include "kwin/utils/delegate.h"
+#include "mbed.h"
+
+namespace kwin {
+
+class DhtReader;
+
+/* @return std::vector<DhtReader *>& Every reader created so far. */
+inline std::vector<DhtReader *> &dhtReaderMockReaders() {
+  static std::vector<DhtReader *> readers;
+  return readers;
+}
+
+/*
+ * @brief Reader of a simulated DHT22. The readings of read n of the sensor
+ * on pin p are 20 + p / 2 + n % 8 / 10 degrees and 40 + p percent.
+ */
+class DhtReader {
+public:
+  // Minimum time between the starts of two reads, set by the sensors.
+  static const uint32_t MINIMUM_INTERVAL_US = 2000000;
+
+  // Time from the start of a read to its deadline: the start pulse and the
+  // deadline of the real reader.
+  static const uint32_t READ_DURATION_US = 1100 + 6000;
+
+  typedef kwin::Delegate<void()> Listener;
+
+  Listener onComplete; // Called when a read finished.
+
+  DhtReader(PinName pin, DhtModel model = DHT_MODEL_DHT22)
+      : pin(pin), busy(false), status(DHT_IDLE), readCount(0),
+        lastStartUs(0) {
+    (void)model;
+    measurement.temperature = 0.0f;
+    measurement.humidity = 0.0f;
+    dhtReaderMockReaders().push_back(this);
+  }
+
+  bool startRead() {
+    if (busy) {
+      return false;
+    }
+    busy = true;
+    status = DHT_DECODING;
+    lastStartUs = us_ticker_read();
+    ++readCount;
+    return true;
+  }
+
+  /* @brief Finishes the read if its deadline passed by 'nowUs'. */
+  void finishIfDue(uint32_t nowUs) {
+    if (!busy || (int32_t)(nowUs - getDeadlineUs()) < 0) {
+      return;
+    }
+    busy = false;
+    status = DHT_COMPLETE;
+    measurement.temperature = 20.0f + pin * 0.5f + readCount % 8 * 0.1f;
+    measurement.humidity = 40.0f + pin;
+    if (onComplete) {
+      onComplete();
+    }
+  }
+
+  bool isBusy() const { return busy; }
+  DhtStatus getStatus() const { return status; }
+  DhtMeasurement getMeasurement() const { return measurement; }
+
+  /* @return uint32_t Reads started so far. */
+  uint32_t getReadCount() const { return readCount; }
+
+  /* @return uint32_t Timestamp of the last read's start. */
+  uint32_t getLastStartUs() const { return lastStartUs; }
+
+  /* @return uint32_t Timestamp at which the current read finishes. */
+  uint32_t getDeadlineUs() const { return lastStartUs + READ_DURATION_US; }
+
+private:
+  PinName pin;                // Data pin, seeds the readings.
+  bool busy;                  // True while a read is in progress.
+  DhtStatus status;           // Result of the last read.
+  uint32_t readCount;         // Reads started so far.
+  uint32_t lastStartUs;       // Timestamp of the last read's start.
+  DhtMeasurement measurement; // Last measurement.
+};
+
+/* @brief Finishes every read whose deadline passed by 'nowUs'. */
+inline void dhtReaderMockFinishReads(uint32_t nowUs) {
+  for (DhtReader *reader : dhtReaderMockReaders()) {
+    reader->finishIfDue(nowUs);
+  }
+}
+
+/*
+ * @brief Finds the earliest deadline of the reads in progress.
+ * @param deadlineUs Set to the deadline, if a read is in progress.
+ * @return bool False if no read is in progress.
+ */
+inline bool dhtReaderMockNextDeadline(uint32_t *deadlineUs) {
+  bool found = false;
+  for (DhtReader *reader : dhtReaderMockReaders()) {
+    if (reader->isBusy() &&
+        (!found || (int32_t)(reader->getDeadlineUs() - *deadlineUs) < 0)) {
+      *deadlineUs = reader->getDeadlineUs();
+      found = true;
+    }
+  }
+  return found;
+}
+} // namespace kwin
+
+#endif
@@ -0,0 +1,207 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#include "lcdMock.h"
+#include <string.h>
+
+uint8_t lcdMockMemory[RK043FN48H_WIDTH * RK043FN48H_HEIGHT * 4];
+
+// Glyphs are not rendered from real font tables, every character gets a
+// pattern of its own instead.
+sFONT Font24 = {NULL, 17, 24};
+sFONT Font20 = {NULL, 14, 20};
+sFONT Font16 = {NULL, 11, 16};
+sFONT Font12 = {NULL, 7, 12};
+sFONT Font8 = {NULL, 5, 8};
+
+static bool isRgb565 = false;
+static uint32_t textColor = LCD_COLOR_BLACK;
+static uint32_t backColor = LCD_COLOR_WHITE;
+static sFONT *font = &Font24;
+static uint32_t pixelWrites = 0;
+
+/* @brief Stores a pixel as is, like the BSP does for lines and text. */
+static void storePixel(int x, int y, uint32_t pixel) {
+  // The real framebuffer wraps to the next row, the mock drops the pixel.
+  if (x < 0 || y < 0 || x >= RK043FN48H_WIDTH || y >= RK043FN48H_HEIGHT) {
+    return;
+  }
+  ++pixelWrites;
+  const int index = y * RK043FN48H_WIDTH + x;
+  if (isRgb565) {
+    ((uint16_t *)lcdMockMemory)[index] = (uint16_t)pixel;
+  } else {
+    ((uint32_t *)lcdMockMemory)[index] = pixel;
+  }
+}
+
+/* @brief Fills a rectangle with an ARGB8888 color, converting it to the
+ * layer's format like the DMA2D does for BSP_LCD_FillRect. */
+static void fill(int x, int y, int width, int height, uint32_t color) {
+  uint32_t pixel = color;
+  if (isRgb565) {
+    pixel = ((color >> 8) & 0xF800) | ((color >> 5) & 0x07E0) |
+            ((color >> 3) & 0x001F);
+  }
+  for (int row = y; row < y + height; ++row) {
+    for (int column = x; column < x + width; ++column) {
+      storePixel(column, row, pixel);
+    }
+  }
+}
+
+uint32_t lcdMockReadPixel(int x, int y) {
+  const int index = y * RK043FN48H_WIDTH + x;
+  if (isRgb565) {
+    return ((const uint16_t *)lcdMockMemory)[index];
+  }
+  return ((const uint32_t *)lcdMockMemory)[index];
+}
+
+bool lcdMockIsRgb565() { return isRgb565; }
+
+uint32_t lcdMockGetPixelWrites() { return pixelWrites; }
+
+uint8_t BSP_LCD_Init(void) {
+  textColor = LCD_COLOR_BLACK;
+  backColor = LCD_COLOR_WHITE;
+  font = &Font24;
+  return 0;
+}
+
+void BSP_LCD_LayerDefaultInit(uint16_t, uintptr_t) { isRgb565 = false; }
+
+void BSP_LCD_LayerRgb565Init(uint16_t, uintptr_t) { isRgb565 = true; }
+
+void BSP_LCD_SelectLayer(uint32_t) {}
+
+uint32_t BSP_LCD_GetXSize(void) { return RK043FN48H_WIDTH; }
+
+uint32_t BSP_LCD_GetYSize(void) { return RK043FN48H_HEIGHT; }
+
+void BSP_LCD_SetTextColor(uint32_t Color) { textColor = Color; }
+
+uint32_t BSP_LCD_GetTextColor(void) { return textColor; }
+
+void BSP_LCD_SetBackColor(uint32_t Color) { backColor = Color; }
+
+uint32_t BSP_LCD_GetBackColor(void) { return backColor; }
+
+void BSP_LCD_SetFont(sFONT *fonts) { font = fonts; }
+
+sFONT *BSP_LCD_GetFont(void) { return font; }
+
+void BSP_LCD_Clear(uint32_t Color) {
+  fill(0, 0, RK043FN48H_WIDTH, RK043FN48H_HEIGHT, Color);
+}
+
+void BSP_LCD_DrawPixel(uint16_t Xpos, uint16_t Ypos, uint32_t pixel) {
+  storePixel(Xpos, Ypos, pixel);
+}
+
+void BSP_LCD_DrawHLine(uint16_t Xpos, uint16_t Ypos, uint16_t Length) {
+  fill(Xpos, Ypos, Length, 1, textColor);
+}
+
+void BSP_LCD_DrawVLine(uint16_t Xpos, uint16_t Ypos, uint16_t Length) {
+  fill(Xpos, Ypos, 1, Length, textColor);
+}
+
+void BSP_LCD_DrawLine(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2) {
+  // The BSP's Bresenham variant, step for step.
+  const int16_t deltax = x2 > x1 ? x2 - x1 : x1 - x2;
+  const int16_t deltay = y2 > y1 ? y2 - y1 : y1 - y2;
+  int16_t x = x1;
+  int16_t y = y1;
+  int16_t xinc1 = x2 >= x1 ? 1 : -1;
+  int16_t xinc2 = xinc1;
+  int16_t yinc1 = y2 >= y1 ? 1 : -1;
+  int16_t yinc2 = yinc1;
+  int16_t den, num, numAdd, numPixels;
+  if (deltax >= deltay) {
+    xinc1 = 0;
+    yinc2 = 0;
+    den = deltax;
+    num = deltax / 2;
+    numAdd = deltay;
+    numPixels = deltax;
+  } else {
+    xinc2 = 0;
+    yinc1 = 0;
+    den = deltay;
+    num = deltay / 2;
+    numAdd = deltax;
+    numPixels = deltay;
+  }
+  for (int16_t pixel = 0; pixel <= numPixels; ++pixel) {
+    storePixel(x, y, textColor);
+    num += numAdd;
+    if (num >= den) {
+      num -= den;
+      x += xinc1;
+      y += yinc1;
+    }
+    x += xinc2;
+    y += yinc2;
+  }
+}
+
+void BSP_LCD_FillRect(uint16_t Xpos, uint16_t Ypos, uint16_t Width,
+                      uint16_t Height) {
+  fill(Xpos, Ypos, Width, Height, textColor);
+}
+
+/* @brief Draws a character cell in the text and back color. */
+static void drawCharacter(int x, int y, uint8_t character) {
+  for (int row = 0; row < font->Height; ++row) {
+    for (int column = 0; column < font->Width; ++column) {
+      const bool set = (character * 31 + row * 7 + column * 3) % 5 < 2;
+      storePixel(x + column, y + row, set ? textColor : backColor);
+    }
+  }
+}
+
+void BSP_LCD_DisplayStringAt(uint16_t Xpos, uint16_t Ypos, uint8_t *Text,
+                             Text_AlignModeTypdef Mode) {
+  // Same alignment and clipping as the BSP.
+  const uint32_t size = strlen((const char *)Text);
+  const uint32_t charactersPerLine = RK043FN48H_WIDTH / font->Width;
+  uint16_t column;
+  switch (Mode) {
+  case CENTER_MODE:
+    column = Xpos + ((charactersPerLine - size) * font->Width) / 2;
+    break;
+  case RIGHT_MODE:
+    column = -Xpos + ((charactersPerLine - size) * font->Width);
+    break;
+  default:
+    column = Xpos;
+    break;
+  }
+  if (column < 1 || column >= 0x8000) {
+    column = 1;
+  }
+
+  for (uint32_t i = 0;
+       Text[i] != 0 &&
+       ((RK043FN48H_WIDTH - i * font->Width) & 0xFFFF) >= font->Width;
+       ++i, column += font->Width) {
+    drawCharacter(column, Ypos, Text[i]);
+  }
+}
+
+void BSP_LCD_DrawBitmap(uint32_t Xpos, uint32_t Ypos, uint8_t *pbmp) {
+  // 24-bit BMP without row padding, bottom row first.
+  const uint32_t offset = pbmp[10] | (pbmp[11] << 8);
+  const uint32_t width = pbmp[18] | (pbmp[19] << 8);
+  const uint32_t height = pbmp[22] | (pbmp[23] << 8);
+  for (uint32_t row = 0; row < height; ++row) {
+    const uint8_t *pixels = pbmp + offset + (height - 1 - row) * width * 3;
+    for (uint32_t column = 0; column < width; ++column, pixels += 3) {
+      const uint32_t color =
+          0xFF000000 | pixels[2] << 16 | pixels[1] << 8 | pixels[0];
+      storePixel(Xpos + column, Ypos + row, color);
+    }
+  }
+}
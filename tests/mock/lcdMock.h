@@ -0,0 +1,19 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#ifndef KWIN_TESTS_MOCK_LCD_MOCK
+#define KWIN_TESTS_MOCK_LCD_MOCK
+
+#include "stm32746g_discovery_lcd.h"
+
+/* @return uint32_t The pixel at x, y: ARGB8888, or RGB565 in RGB565 mode. */
+uint32_t lcdMockReadPixel(int x, int y);
+
+/* @return bool True if the active layer was initialized as RGB565. */
+bool lcdMockIsRgb565();
+
+/* @return uint32_t Pixels written since boot, by fills and single pixels. */
+uint32_t lcdMockGetPixelWrites();
+
+#endif
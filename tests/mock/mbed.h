@@ -0,0 +1,53 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+// Host mock of the parts of the mbed API the tested sources use.
+
+#ifndef KWIN_TESTS_MOCK_MBED
+#define KWIN_TESTS_MOCK_MBED
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Arduino header pins of the DISCO-F746NG.
+enum PinName {
+  D0, D1, D2, D3, D4, D5, D6, D7, D8, D9, D10, D11, D12, D13, D14, D15,
+  A0, A1, A2, A3, A4, A5,
+  USBTX, USBRX,
+  NC = -1
+};
+
+/* @return uint16_t& The reading every AnalogIn returns, as read_u16. */
+inline uint16_t &analogInMockValue() {
+  static uint16_t value = 0;
+  return value;
+}
+
+/* @brief Analog input reading analogInMockValue(). */
+class AnalogIn {
+public:
+  AnalogIn(PinName) {}
+  float read() { return analogInMockValue() * (1.0f / 0xFFFF); }
+  uint16_t read_u16() { return analogInMockValue(); }
+};
+
+/* @return uint32_t Microseconds of the board's timer. Defined by the tests
+ * that need it. */
+uint32_t us_ticker_read();
+
+/* @brief Serial port printing to stdout. */
+class Serial {
+public:
+  Serial(PinName, PinName) {}
+  int printf(const char *format, ...) {
+    va_list arguments;
+    va_start(arguments, format);
+    const int length = vprintf(format, arguments);
+    va_end(arguments);
+    return length;
+  }
+};
+
+#endif
@@ -0,0 +1,79 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+// Host mock of the BSP_LCD API of the DISCO-F746NG, drawing into a
+// framebuffer in memory. See lcdMock.h for reading it back.
+
+#ifndef KWIN_TESTS_MOCK_LCD
+#define KWIN_TESTS_MOCK_LCD
+
+#include <stdint.h>
+
+#define LCD_COLOR_BLUE ((uint32_t)0xFF0000FF)
+#define LCD_COLOR_GREEN ((uint32_t)0xFF00FF00)
+#define LCD_COLOR_RED ((uint32_t)0xFFFF0000)
+#define LCD_COLOR_CYAN ((uint32_t)0xFF00FFFF)
+#define LCD_COLOR_MAGENTA ((uint32_t)0xFFFF00FF)
+#define LCD_COLOR_YELLOW ((uint32_t)0xFFFFFF00)
+#define LCD_COLOR_LIGHTBLUE ((uint32_t)0xFF8080FF)
+#define LCD_COLOR_DARKBLUE ((uint32_t)0xFF000080)
+#define LCD_COLOR_WHITE ((uint32_t)0xFFFFFFFF)
+#define LCD_COLOR_GRAY ((uint32_t)0xFF808080)
+#define LCD_COLOR_DARKGRAY ((uint32_t)0xFF404040)
+#define LCD_COLOR_BLACK ((uint32_t)0xFF000000)
+#define LCD_COLOR_ORANGE ((uint32_t)0xFFFFA500)
+
+#define RK043FN48H_WIDTH ((uint16_t)480)
+#define RK043FN48H_HEIGHT ((uint16_t)272)
+
+#define LTDC_ACTIVE_LAYER ((uint32_t)1)
+
+// The framebuffer, 4 bytes per pixel so it fits either pixel format.
+extern uint8_t lcdMockMemory[RK043FN48H_WIDTH * RK043FN48H_HEIGHT * 4];
+#define LCD_FB_START_ADDRESS ((uintptr_t)lcdMockMemory)
+
+typedef struct _tFont {
+  const uint8_t *table;
+  uint16_t Width;
+  uint16_t Height;
+} sFONT;
+
+extern sFONT Font24;
+extern sFONT Font20;
+extern sFONT Font16;
+extern sFONT Font12;
+extern sFONT Font8;
+
+typedef enum {
+  CENTER_MODE = 0x01,
+  RIGHT_MODE = 0x02,
+  LEFT_MODE = 0x03
+} Text_AlignModeTypdef;
+
+uint8_t BSP_LCD_Init(void);
+void BSP_LCD_LayerDefaultInit(uint16_t LayerIndex, uintptr_t FB_Address);
+void BSP_LCD_LayerRgb565Init(uint16_t LayerIndex, uintptr_t FB_Address);
+void BSP_LCD_SelectLayer(uint32_t LayerIndex);
+uint32_t BSP_LCD_GetXSize(void);
+uint32_t BSP_LCD_GetYSize(void);
+
+void BSP_LCD_SetTextColor(uint32_t Color);
+uint32_t BSP_LCD_GetTextColor(void);
+void BSP_LCD_SetBackColor(uint32_t Color);
+uint32_t BSP_LCD_GetBackColor(void);
+void BSP_LCD_SetFont(sFONT *fonts);
+sFONT *BSP_LCD_GetFont(void);
+
+void BSP_LCD_Clear(uint32_t Color);
+void BSP_LCD_DrawPixel(uint16_t Xpos, uint16_t Ypos, uint32_t pixel);
+void BSP_LCD_DrawHLine(uint16_t Xpos, uint16_t Ypos, uint16_t Length);
+void BSP_LCD_DrawVLine(uint16_t Xpos, uint16_t Ypos, uint16_t Length);
+void BSP_LCD_DrawLine(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2);
+void BSP_LCD_FillRect(uint16_t Xpos, uint16_t Ypos, uint16_t Width,
+                      uint16_t Height);
+void BSP_LCD_DisplayStringAt(uint16_t Xpos, uint16_t Ypos, uint8_t *Text,
+                             Text_AlignModeTypdef Mode);
+void BSP_LCD_DrawBitmap(uint32_t Xpos, uint32_t Ypos, uint8_t *pbmp);
+
+#endif
@@ -0,0 +1,185 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#include <chrono>
+#include <random>
+#include <string.h>
+#include <vector>
+
+#include "check.h"
+#include "kwin/graphics/lcdLayer.h"
+#include "lcdMock.h"
+
+const int WIDTH = RK043FN48H_WIDTH;
+const int HEIGHT = RK043FN48H_HEIGHT;
+const uint16_t GUARD = 0xDEAD;
+
+/* @brief Reference fill, one pixel per store. */
+void scalarFill(uint16_t *framebuffer, uint32_t stride, uint32_t x, uint32_t y,
+                uint32_t width, uint32_t height, uint16_t color) {
+  for (uint32_t row = y; row < y + height; ++row) {
+    volatile uint16_t *pixel = framebuffer + row * stride + x;
+    for (uint32_t column = 0; column < width; ++column) {
+      pixel[column] = color;
+    }
+  }
+}
+
+/* @brief Spans of every length at both halfword alignments stay in bounds. */
+void testFillSpan() {
+  uint16_t buffer[64];
+  for (int offset = 0; offset < 4; ++offset) {
+    for (int count = 0; count <= 40; ++count) {
+      for (int i = 0; i < 64; ++i) {
+        buffer[i] = GUARD;
+      }
+      kwin::rgb565::fillSpan(buffer + offset, count, 0x1234);
+      int wrong = 0;
+      for (int i = 0; i < 64; ++i) {
+        const bool inside = i >= offset && i < offset + count;
+        wrong += buffer[i] != (inside ? 0x1234 : GUARD);
+      }
+      CHECK(wrong == 0);
+    }
+  }
+}
+
+/* @brief Blits copy the same pixels at matching and mismatched alignments. */
+void testBlitRect() {
+  std::vector<uint16_t> source(33 * 9);
+  for (size_t i = 0; i < source.size(); ++i) {
+    source[i] = i * 2654435761u >> 16;
+  }
+  for (int sourceOffset = 0; sourceOffset < 2; ++sourceOffset) {
+    for (int x = 0; x < 4; ++x) {
+      std::vector<uint16_t> framebuffer(40 * 12, GUARD);
+      kwin::rgb565::blitRect(framebuffer.data(), 40, x, 1,
+                             source.data() + sourceOffset, 33, 31, 9);
+      int wrong = 0;
+      for (int row = 0; row < 12; ++row) {
+        for (int column = 0; column < 40; ++column) {
+          const bool inside =
+              row >= 1 && row < 10 && column >= x && column < x + 31;
+          const uint16_t expected =
+              inside ? source[(row - 1) * 33 + sourceOffset + column - x]
+                     : GUARD;
+          wrong += framebuffer[row * 40 + column] != expected;
+        }
+      }
+      CHECK(wrong == 0);
+    }
+  }
+}
+
+/* @brief Every RGB565 color survives a round trip through ARGB8888. */
+void testConversions() {
+  int wrong = 0;
+  for (uint32_t color = 0; color <= 0xFFFF; ++color) {
+    wrong += kwin::rgb565::fromArgb8888(kwin::rgb565::toArgb8888(color)) !=
+             color;
+  }
+  CHECK(wrong == 0);
+  CHECK(kwin::rgb565::fromArgb8888(LCD_COLOR_WHITE) == 0xFFFF);
+  CHECK(kwin::rgb565::toArgb8888(0xFFFF) == LCD_COLOR_WHITE);
+  CHECK(kwin::rgb565::fromArgb8888(LCD_COLOR_RED) == 0xF800);
+}
+
+/*
+ * @brief fillLayerRect gives the same pixels whether a fill takes the CPU
+ * kernel or BSP_LCD_FillRect.
+ */
+void testFillLayerRect() {
+  kwin::initializeLcdLayer();
+  CHECK(lcdMockIsRgb565());
+
+  std::mt19937 generator(3);
+  const uint32_t colors[] = {LCD_COLOR_RED, LCD_COLOR_ORANGE,
+                             LCD_COLOR_DARKGRAY, LCD_COLOR_CYAN};
+  std::vector<uint16_t> expected(WIDTH * HEIGHT, 0);
+  memset(lcdMockMemory, 0, sizeof(lcdMockMemory));
+  int kernelFills = 0;
+  for (int i = 0; i < 500; ++i) {
+    const int width = 1 + generator() % (i % 2 ? 40 : WIDTH);
+    const int height = 1 + generator() % (i % 2 ? 20 : HEIGHT);
+    const int x = generator() % (WIDTH - width + 1);
+    const int y = generator() % (HEIGHT - height + 1);
+    const uint32_t color = colors[generator() % 4];
+    kernelFills += width * height <= KWIN_LCD_CPU_FILL_MAX_PIXELS;
+
+    const uint32_t writesBefore = lcdMockGetPixelWrites();
+    kwin::fillLayerRect(x, y, width, height, color);
+    const uint32_t bspWrites = lcdMockGetPixelWrites() - writesBefore;
+    // Only large fills reach the BSP.
+    CHECK(bspWrites == (width * height > KWIN_LCD_CPU_FILL_MAX_PIXELS
+                            ? (uint32_t)(width * height)
+                            : 0));
+    scalarFill(expected.data(), WIDTH, x, y, width, height,
+               kwin::rgb565::fromArgb8888(color));
+  }
+  CHECK(kernelFills > 100);
+  CHECK(memcmp(expected.data(), lcdMockMemory,
+               expected.size() * sizeof(uint16_t)) == 0);
+}
+
+typedef std::chrono::steady_clock Clock;
+
+/*
+ * @brief Measures fills of one size with the kernel and the scalar loop.
+ * @return double Kernel speedup over the scalar loop.
+ */
+double benchmarkFill(std::vector<uint16_t> &framebuffer, int width,
+                     int height) {
+  const int fills = 2000000 / (width * height) + 100;
+  const Clock::time_point kernelStart = Clock::now();
+  for (int i = 0; i < fills; ++i) {
+    kwin::rgb565::fillRect(framebuffer.data(), WIDTH, i % 2, 0, width, height,
+                           i);
+  }
+  const Clock::time_point scalarStart = Clock::now();
+  for (int i = 0; i < fills; ++i) {
+    scalarFill(framebuffer.data(), WIDTH, i % 2, 0, width, height, i);
+  }
+  const Clock::time_point end = Clock::now();
+
+  const double kernelNs =
+      std::chrono::duration<double, std::nano>(scalarStart - kernelStart)
+          .count() /
+      fills;
+  const double scalarNs =
+      std::chrono::duration<double, std::nano>(end - scalarStart).count() /
+      fills;
+  const double pixels = width * height;
+  printf("%3dx%-3d fill: kernel %9.1f ns (%6.0f Mpixel/s), scalar %9.1f ns "
+         "(%6.0f Mpixel/s)\n",
+         width, height, kernelNs, pixels * 1000 / kernelNs, scalarNs,
+         pixels * 1000 / scalarNs);
+  return scalarNs / kernelNs;
+}
+
+/*
+ * @brief Fill rates of the RGB565 kernel against one store per pixel, from
+ * single pixels up to a full clear. Host rates don't carry over to the
+ * target's SDRAM, and the DMA2D path can't be timed here; see
+ * KWIN_LCD_CPU_FILL_MAX_PIXELS for how the two are split.
+ */
+void benchmarkFills() {
+  std::vector<uint16_t> framebuffer(WIDTH * HEIGHT);
+  const int sizes[][2] = {{1, 1},   {8, 1},    {16, 16},     {32, 16},
+                          {64, 24}, {240, 40}, {WIDTH, HEIGHT}};
+  double fullClearSpeedup = 0;
+  for (const auto &size : sizes) {
+    fullClearSpeedup = benchmarkFill(framebuffer, size[0], size[1]);
+  }
+  // Wide rows are where the word stores pay off.
+  CHECK(fullClearSpeedup > 1.5);
+}
+
+int main() {
+  testFillSpan();
+  testBlitRect();
+  testConversions();
+  testFillLayerRect();
+  benchmarkFills();
+  return finishTests();
+}
@@ -0,0 +1,265 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#include <random>
+#include <string.h>
+#include <vector>
+
+#include "check.h"
+#include "kwin/storage/snapshotStore.h"
+
+/*
+ * @brief Block store in memory with the semantics of NOR flash. Counts its
+ * reads and erases, and can cut the power in the middle of programming.
+ */
+class MemoryBlockStore : public kwin::BlockStore {
+public:
+  MemoryBlockStore(uint32_t size, uint32_t eraseSize, uint32_t programSize)
+      : bytes(size, ERASE_VALUE), eraseSize(eraseSize),
+        programSize(programSize), readBytes(0), eraseCount(0),
+        programBudget(-1) {}
+
+  bool init() { return true; }
+
+  bool read(uint32_t offset, void *buffer, uint32_t size) {
+    if (offset + size > bytes.size()) {
+      return false;
+    }
+    memcpy(buffer, &bytes[offset], size);
+    readBytes += size;
+    return true;
+  }
+
+  bool program(uint32_t offset, const void *buffer, uint32_t size) {
+    if (offset % programSize != 0 || size % programSize != 0 ||
+        offset + size > bytes.size()) {
+      return false;
+    }
+    const uint8_t *source = (const uint8_t *)buffer;
+    for (uint32_t i = 0; i < size; ++i) {
+      if (programBudget == 0) {
+        return false; // The power is gone.
+      }
+      if (programBudget > 0) {
+        --programBudget;
+      }
+      bytes[offset + i] &= source[i];
+    }
+    return true;
+  }
+
+  bool erase(uint32_t offset, uint32_t size) {
+    if (offset % eraseSize != 0 || size % eraseSize != 0 ||
+        offset + size > bytes.size()) {
+      return false;
+    }
+    memset(&bytes[offset], ERASE_VALUE, size);
+    ++eraseCount;
+    return true;
+  }
+
+  uint32_t getSize() { return bytes.size(); }
+  uint32_t getEraseSize() { return eraseSize; }
+  uint32_t getProgramSize() { return programSize; }
+  uint8_t getEraseValue() { return ERASE_VALUE; }
+
+  static const uint8_t ERASE_VALUE = 0xFF;
+
+  std::vector<uint8_t> bytes; // Contents of the store.
+  uint32_t eraseSize;         // Size of an erase unit.
+  uint32_t programSize;       // Size of a program unit.
+  uint32_t readBytes;         // Bytes read.
+  int eraseCount;             // Calls to erase.
+  int programBudget;          // Bytes programmed before the power cut, or -1.
+};
+
+const uint32_t SNAPSHOT_SIZE = 1000;
+// Snapshots per bank: records of a 16 byte header and the payload.
+const int SNAPSHOTS_PER_BANK = 4096 / (16 + SNAPSHOT_SIZE);
+
+/* @brief A snapshot starting with its number, every other byte deriving
+ * from it. */
+std::vector<uint8_t> makeSnapshot(uint32_t number) {
+  std::vector<uint8_t> snapshot(SNAPSHOT_SIZE);
+  for (uint32_t i = 0; i < SNAPSHOT_SIZE; ++i) {
+    snapshot[i] = (uint8_t)(number * 131 + i * 7);
+  }
+  memcpy(snapshot.data(), &number, sizeof(number));
+  return snapshot;
+}
+
+/* @return uint32_t Number of the restored snapshot, 0 if there is none. */
+uint32_t restoreNumber(kwin::SnapshotStore &snapshots) {
+  std::vector<uint8_t> snapshot(SNAPSHOT_SIZE);
+  uint32_t size = 0;
+  if (!snapshots.restore(snapshot.data(), snapshot.size(), &size)) {
+    return 0;
+  }
+  CHECK(size == SNAPSHOT_SIZE);
+  uint32_t number;
+  memcpy(&number, snapshot.data(), sizeof(number));
+  CHECK(snapshot == makeSnapshot(number));
+  return number;
+}
+
+/*
+ * @brief Saves never erase: a full active bank moves on to the erased spare
+ * bank, and once both are full saves fail until the spare is erased.
+ */
+void testSaveNeverErases() {
+  MemoryBlockStore flash(2 * 4096, 4096, 8);
+  kwin::SnapshotStore snapshots(flash);
+  CHECK(!snapshots.needsErase()); // Fresh flash is erased.
+
+  uint32_t number = 0;
+  for (int i = 0; i < 2 * SNAPSHOTS_PER_BANK; ++i) {
+    CHECK(snapshots.save(makeSnapshot(++number).data(), SNAPSHOT_SIZE));
+    // The first bank filled up, the second one took over.
+    CHECK(snapshots.needsErase() == (i >= SNAPSHOTS_PER_BANK));
+  }
+  CHECK(flash.eraseCount == 0);
+
+  // Both banks are full.
+  CHECK(!snapshots.save(makeSnapshot(number + 1).data(), SNAPSHOT_SIZE));
+  CHECK(flash.eraseCount == 0);
+  CHECK(restoreNumber(snapshots) == number);
+
+  // Erasing the spare bank, at a moment of the owner's choosing, keeps the
+  // latest snapshot and makes room again.
+  CHECK(snapshots.eraseSpareBank());
+  CHECK(flash.eraseCount == 1);
+  CHECK(!snapshots.needsErase());
+  CHECK(snapshots.eraseSpareBank()); // Nothing left to erase.
+  CHECK(flash.eraseCount == 1);
+  CHECK(restoreNumber(snapshots) == number);
+  CHECK(snapshots.save(makeSnapshot(++number).data(), SNAPSHOT_SIZE));
+  CHECK(restoreNumber(snapshots) == number);
+  CHECK(snapshots.getEraseCount() == 1);
+}
+
+/* @brief A reset remembers whether the spare bank still needs an erase. */
+void testRemount() {
+  MemoryBlockStore flash(2 * 4096, 4096, 8);
+  uint32_t number = 0;
+  {
+    kwin::SnapshotStore snapshots(flash);
+    for (int i = 0; i <= SNAPSHOTS_PER_BANK; ++i) {
+      CHECK(snapshots.save(makeSnapshot(++number).data(), SNAPSHOT_SIZE));
+    }
+    CHECK(snapshots.needsErase());
+  }
+  {
+    kwin::SnapshotStore snapshots(flash);
+    CHECK(restoreNumber(snapshots) == number);
+    CHECK(snapshots.needsErase());
+    CHECK(snapshots.eraseSpareBank());
+  }
+  kwin::SnapshotStore snapshots(flash);
+  CHECK(restoreNumber(snapshots) == number);
+  CHECK(!snapshots.needsErase());
+  CHECK(snapshots.save(makeSnapshot(++number).data(), SNAPSHOT_SIZE));
+  CHECK(restoreNumber(snapshots) == number);
+}
+
+/*
+ * @brief Mounting reads the record headers and the newest payload only, and
+ * a newest record failing its CRC check falls back to the one before it.
+ */
+void testMountReadsNewestPayload() {
+  MemoryBlockStore flash(2 * 4096, 4096, 8);
+  uint32_t number = 0;
+  {
+    kwin::SnapshotStore snapshots(flash);
+    for (int i = 0; i < SNAPSHOTS_PER_BANK + 2; ++i) {
+      CHECK(snapshots.save(makeSnapshot(++number).data(), SNAPSHOT_SIZE));
+    }
+  }
+
+  {
+    kwin::SnapshotStore snapshots(flash);
+    flash.readBytes = 0;
+    CHECK(snapshots.needsErase()); // Mounts, bank 0 is full.
+    // The CRC check reads one payload, the rest are headers and the start
+    // of the spare bank.
+    CHECK(flash.readBytes >= SNAPSHOT_SIZE);
+    CHECK(flash.readBytes < 2 * SNAPSHOT_SIZE);
+    CHECK(restoreNumber(snapshots) == number);
+  }
+
+  // Corrupt the payload of the newest snapshot, the second one of bank 1.
+  flash.bytes[4096 + (16 + SNAPSHOT_SIZE) + 16 + 100] ^= 0x01;
+  {
+    kwin::SnapshotStore snapshots(flash);
+    flash.readBytes = 0;
+    CHECK(restoreNumber(snapshots) == number - 1);
+    CHECK(flash.readBytes >= 3 * SNAPSHOT_SIZE); // Two checks and a read.
+    CHECK(flash.readBytes < 4 * SNAPSHOT_SIZE);
+  }
+
+  // Corrupt every snapshot of bank 1, the newest of bank 0 is restored.
+  flash.bytes[4096 + 16 + 100] ^= 0x01;
+  {
+    kwin::SnapshotStore snapshots(flash);
+    CHECK(restoreNumber(snapshots) == number - 2);
+    // Saving continues after the newest sequence number restored.
+    CHECK(snapshots.getSequence() == number - 2);
+  }
+}
+
+/*
+ * @brief The graph demo's schedule over many resets, some of them cutting a
+ * save short: save a staged snapshot, else erase the spare bank if needed.
+ * Every boot restores the last completed snapshot, and only the schedule
+ * erases.
+ */
+void testTornSaves() {
+  MemoryBlockStore flash(2 * 4096, 4096, 8);
+  std::mt19937 generator(17);
+  uint32_t number = 0;
+  uint32_t lastSaved = 0;
+  int savesCompleted = 0;
+  int savesFailed = 0;
+  for (int boot = 0; boot < 300; ++boot) {
+    kwin::SnapshotStore snapshots(flash);
+    CHECK(restoreNumber(snapshots) == lastSaved);
+
+    const int saves = generator() % 8;
+    for (int i = 0; i <= saves; ++i) {
+      const bool tear = i == saves && generator() % 2;
+      if (tear) {
+        flash.programBudget = generator() % (16 + SNAPSHOT_SIZE);
+      }
+      const int erasesBefore = flash.eraseCount;
+      if (snapshots.save(makeSnapshot(++number).data(), SNAPSHOT_SIZE)) {
+        lastSaved = number;
+        ++savesCompleted;
+      } else {
+        ++savesFailed;
+      }
+      CHECK(flash.eraseCount == erasesBefore);
+      flash.programBudget = -1;
+      if (tear) {
+        break; // The power is gone, reboot.
+      }
+      if (snapshots.needsErase()) {
+        CHECK(snapshots.eraseSpareBank());
+      }
+    }
+  }
+  printf("Torn saves: %d saves completed, %d failed, %d erases\n",
+         savesCompleted, savesFailed, flash.eraseCount);
+  CHECK(savesCompleted > 500);
+  // A torn record abandons the rest of its bank, so some banks hold fewer
+  // snapshots, but never more than one erase per completed save.
+  CHECK(flash.eraseCount > savesCompleted / (2 * SNAPSHOTS_PER_BANK));
+  CHECK(flash.eraseCount <= savesCompleted);
+}
+
+int main() {
+  testSaveNeverErases();
+  testRemount();
+  testMountReadsNewestPayload();
+  testTornSaves();
+  return finishTests();
+}
@@ -0,0 +1,190 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "check.h"
+#include "kwin/utils/statistics.h"
+
+/* @brief Exact statistics of a window, computed in double. */
+struct ExactStatistics {
+  double mean;
+  double variance;
+  float minimum;
+  float maximum;
+};
+
+ExactStatistics computeExact(const std::vector<float> &samples, size_t begin,
+                             size_t end) {
+  ExactStatistics exact;
+  double sum = 0.0;
+  exact.minimum = samples[begin];
+  exact.maximum = samples[begin];
+  for (size_t i = begin; i < end; ++i) {
+    sum += samples[i];
+    exact.minimum = std::min(exact.minimum, samples[i]);
+    exact.maximum = std::max(exact.maximum, samples[i]);
+  }
+  exact.mean = sum / (end - begin);
+  double squaredDistanceSum = 0.0;
+  for (size_t i = begin; i < end; ++i) {
+    const double distance = samples[i] - exact.mean;
+    squaredDistanceSum += distance * distance;
+  }
+  exact.variance = squaredDistanceSum / (end - begin - 1);
+  return exact;
+}
+
+/*
+ * @brief A sliding window over a long run, like months of sensor uptime: the
+ * mean and variance must not drift away from the window's exact values.
+ */
+void testSlidingWindowDoesNotDrift() {
+  const int WINDOW = 100;
+  const int SAMPLES = 2000000;
+  kwin::SlidingWindowStatistics<WINDOW> statistics;
+
+  // A large offset with small noise and slow swings is the worst case for
+  // removing samples in float.
+  std::mt19937 random(1);
+  std::normal_distribution<float> noise(0.0f, 0.5f);
+  std::vector<float> samples(SAMPLES);
+  for (int i = 0; i < SAMPLES; ++i) {
+    samples[i] = 1000.0f + 50.0f * sinf(i * 0.0001f) + noise(random);
+  }
+
+  double worstMeanError = 0.0;
+  double worstVarianceError = 0.0;
+  for (int i = 0; i < SAMPLES; ++i) {
+    statistics.add(samples[i]);
+    if (i + 1 < WINDOW || i % 997 != 0) {
+      continue;
+    }
+
+    const ExactStatistics exact = computeExact(samples, i + 1 - WINDOW, i + 1);
+    const kwin::StatisticsSnapshot window = statistics.read();
+    CHECK(window.count == (uint32_t)WINDOW);
+    CHECK(window.minimum == exact.minimum);
+    CHECK(window.maximum == exact.maximum);
+    worstMeanError = std::max(worstMeanError, fabs(window.mean - exact.mean));
+    worstVarianceError =
+        std::max(worstVarianceError,
+                 fabs(window.variance - exact.variance) / exact.variance);
+  }
+
+  printf("Sliding window after %d samples: mean error %.3g, relative "
+         "variance error %.3g\n",
+         SAMPLES, worstMeanError, worstVarianceError);
+  // A float holds 1000 to 6e-5, allow the rounding errors of one lap.
+  CHECK(worstMeanError < 5e-3);
+  CHECK(worstVarianceError < 0.02);
+}
+
+/* @brief A partially filled window reports the samples it has. */
+void testSlidingWindowFilling() {
+  kwin::SlidingWindowStatistics<8> statistics;
+  CHECK(statistics.read().count == 0);
+
+  const float samples[] = {4.0f, 1.0f, 7.0f};
+  for (float sample : samples) {
+    statistics.add(sample);
+  }
+  const kwin::StatisticsSnapshot window = statistics.read();
+  CHECK(window.count == 3);
+  CHECK_NEAR(window.mean, 4.0, 1e-6);
+  CHECK_NEAR(window.variance, 9.0, 1e-5);
+  CHECK(window.minimum == 1.0f);
+  CHECK(window.maximum == 7.0f);
+  CHECK_NEAR(window.rateOfChange, 1.5, 1e-6);
+  CHECK(window.median == 4.0f);
+}
+
+/* @brief Readers see the last completed window of a tumbling window. */
+void testTumblingWindow() {
+  const int WINDOW = 50;
+  kwin::TumblingWindowStatistics<WINDOW> statistics;
+  CHECK(statistics.read().count == 0);
+
+  std::mt19937 random(2);
+  std::uniform_real_distribution<float> uniform(-10.0f, 10.0f);
+  std::vector<float> samples;
+  for (int window = 0; window < 20; ++window) {
+    for (int i = 0; i < WINDOW; ++i) {
+      samples.push_back(uniform(random));
+      statistics.add(samples.back());
+      if (i < WINDOW - 1) {
+        // The window is in progress, the previous one is still shown.
+        const uint32_t shownCount = window == 0 ? 0 : WINDOW;
+        CHECK(statistics.read().count == shownCount);
+      }
+    }
+
+    const size_t begin = samples.size() - WINDOW;
+    const ExactStatistics exact = computeExact(samples, begin, samples.size());
+    const kwin::StatisticsSnapshot completed = statistics.read();
+    CHECK(completed.count == (uint32_t)WINDOW);
+    CHECK_NEAR(completed.mean, exact.mean, 1e-4);
+    CHECK_NEAR(completed.variance, exact.variance, 1e-3 * exact.variance);
+    CHECK(completed.minimum == exact.minimum);
+    CHECK(completed.maximum == exact.maximum);
+    CHECK_NEAR(completed.rateOfChange,
+               (samples.back() - samples[begin]) / (WINDOW - 1), 1e-5);
+  }
+}
+
+/* @brief The P-square estimates converge to the exact quantiles. */
+void testP2Quantile() {
+  std::mt19937 random(3);
+  std::uniform_real_distribution<float> uniform(0.0f, 100.0f);
+  kwin::P2Quantile median(0.5f);
+  kwin::P2Quantile percentile90(0.9f);
+  CHECK(median.getValue() == 0.0f);
+
+  for (int i = 0; i < 100000; ++i) {
+    const float sample = uniform(random);
+    median.add(sample);
+    percentile90.add(sample);
+  }
+  CHECK(median.getCount() == 100000);
+  CHECK_NEAR(median.getValue(), 50.0, 1.0);
+  CHECK_NEAR(percentile90.getValue(), 90.0, 1.0);
+
+  // Less than five samples: the sorted samples themselves.
+  kwin::P2Quantile few(0.5f);
+  few.add(3.0f);
+  few.add(1.0f);
+  few.add(2.0f);
+  CHECK(few.getValue() == 2.0f);
+}
+
+/* @brief The percentiles of a sliding window follow the recent samples. */
+void testSlidingWindowPercentiles() {
+  const int WINDOW = 200;
+  kwin::SlidingWindowStatistics<WINDOW> statistics;
+  std::mt19937 random(4);
+  std::normal_distribution<float> noise(0.0f, 1.0f);
+
+  // A step: the estimates must leave the old level within a window.
+  for (int i = 0; i < 5 * WINDOW; ++i) {
+    statistics.add(noise(random));
+  }
+  for (int i = 0; i < 2 * WINDOW; ++i) {
+    statistics.add(20.0f + noise(random));
+  }
+  const kwin::StatisticsSnapshot window = statistics.read();
+  CHECK_NEAR(window.median, 20.0, 0.5);
+  // The 90th percentile of a normal distribution is 1.28 sigma above the mean.
+  CHECK_NEAR(window.percentile90, 21.28, 0.6);
+}
+
+int main() {
+  testSlidingWindowDoesNotDrift();
+  testSlidingWindowFilling();
+  testTumblingWindow();
+  testP2Quantile();
+  testSlidingWindowPercentiles();
+  return finishTests();
+}
@@ -0,0 +1,186 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#include <type_traits>
+#include <vector>
+
+#include "check.h"
+#include "kwin/utils/ringBuffer.h"
+#include "kwin/utils/temperatureConversion.h"
+
+// The conversions as they were written before they became generic, with
+// double literals. Integer results are these, truncated.
+double baselineKelvinToCelsius(double degrees) { return degrees - 273.15; }
+double baselineKelvinToFahrenheit(double degrees) {
+  return (degrees - 273.15) * 1.8 + 32;
+}
+double baselineFahrenheitToCelsius(double degrees) {
+  return (degrees - 32) / 1.8;
+}
+double baselineFahrenheitToKelvin(double degrees) {
+  return (degrees - 32) / 1.8 + 273.15;
+}
+double baselineCelsiusToKelvin(double degrees) { return degrees + 273.15; }
+double baselineCelsiusToFahrenheit(double degrees) {
+  return degrees * 1.8 + 32;
+}
+
+/* @brief Integer conversions give the truncated results they always gave. */
+template <typename T> void testIntegerMatchesBaseline() {
+  int wrong = 0;
+  for (int degrees = -100000; degrees <= 100000; ++degrees) {
+    const T value = T(degrees);
+    wrong += convertKelvinToCelsius(value) !=
+             T(baselineKelvinToCelsius(degrees));
+    wrong += convertKelvinToFahrenheit(value) !=
+             T(baselineKelvinToFahrenheit(degrees));
+    wrong += convertFahrenheitToCelsius(value) !=
+             T(baselineFahrenheitToCelsius(degrees));
+    wrong += convertFahrenheitToKelvin(value) !=
+             T(baselineFahrenheitToKelvin(degrees));
+    wrong += convertCelsiusToKelvin(value) !=
+             T(baselineCelsiusToKelvin(degrees));
+    wrong += convertCelsiusToFahrenheit(value) !=
+             T(baselineCelsiusToFahrenheit(degrees));
+  }
+  CHECK(wrong == 0);
+  CHECK(convertCelsiusToKelvin(T(0)) == 273);
+  CHECK(convertKelvinToCelsius(T(0)) == -273);
+}
+
+/* @brief Float conversions agree with the double ones to float precision. */
+void testFloatMatchesBaseline() {
+  static_assert(
+      std::is_same<kwin::TemperatureArithmetic<float>::Type, float>::value,
+      "Float conversions stay in single precision");
+  static_assert(
+      std::is_same<kwin::TemperatureArithmetic<int>::Type, double>::value,
+      "Integer conversions are computed in double");
+
+  double worst = 0;
+  for (int i = -4000; i <= 4000; ++i) {
+    const float degrees = i * 0.25f;
+    const double errors[] = {
+        convertKelvinToCelsius(degrees) - baselineKelvinToCelsius(degrees),
+        convertKelvinToFahrenheit(degrees) -
+            baselineKelvinToFahrenheit(degrees),
+        convertFahrenheitToCelsius(degrees) -
+            baselineFahrenheitToCelsius(degrees),
+        convertFahrenheitToKelvin(degrees) -
+            baselineFahrenheitToKelvin(degrees),
+        convertCelsiusToKelvin(degrees) - baselineCelsiusToKelvin(degrees),
+        convertCelsiusToFahrenheit(degrees) -
+            baselineCelsiusToFahrenheit(degrees)};
+    for (double error : errors) {
+      worst = fmax(worst, fabs(error));
+    }
+  }
+  // A few ulps of values up to about 2100.
+  CHECK(worst < 1e-3);
+  CHECK(convertCelsiusToFahrenheit(100.0f) == 212.0f);
+  CHECK(convertFahrenheitToCelsius(212.0) == 100.0);
+}
+
+/* @brief Buffers convert like the single value conversions, in place too. */
+void testConvertTemperatures() {
+  const kwin::TemperatureUnit units[] = {
+      kwin::UNIT_CELSIUS, kwin::UNIT_FAHRENHEIT, kwin::UNIT_KELVIN};
+  double (*const baselines[3][3])(double) = {
+      {NULL, baselineCelsiusToFahrenheit, baselineCelsiusToKelvin},
+      {baselineFahrenheitToCelsius, NULL, baselineFahrenheitToKelvin},
+      {baselineKelvinToCelsius, baselineKelvinToFahrenheit, NULL}};
+
+  std::vector<float> source;
+  for (int i = -200; i <= 200; ++i) {
+    source.push_back(i * 1.5f);
+  }
+  for (int from = 0; from < 3; ++from) {
+    for (int to = 0; to < 3; ++to) {
+      std::vector<float> converted(source.size());
+      kwin::convertTemperatures(source.data(), converted.data(),
+                                source.size(), units[from], units[to]);
+      std::vector<float> inPlace = source;
+      kwin::convertTemperatures(inPlace.data(), inPlace.size(), units[from],
+                                units[to]);
+      CHECK(inPlace == converted);
+
+      double worst = 0;
+      for (size_t i = 0; i < source.size(); ++i) {
+        const double expected =
+            baselines[from][to] ? baselines[from][to](source[i]) : source[i];
+        worst = fmax(worst, fabs(converted[i] - expected));
+      }
+      CHECK(worst < 1e-3);
+
+      // Converting back restores the values.
+      kwin::convertTemperatures(inPlace.data(), inPlace.size(), units[to],
+                                units[from]);
+      worst = 0;
+      for (size_t i = 0; i < source.size(); ++i) {
+        worst = fmax(worst, fabs(inPlace[i] - source[i]));
+      }
+      CHECK(worst < 1e-3);
+    }
+  }
+}
+
+/* @brief Differences, e.g. standard deviations, are only scaled. */
+void testDifferences() {
+  const kwin::LinearConversion<float> toFahrenheit =
+      kwin::getTemperatureConversion<float>(kwin::UNIT_CELSIUS,
+                                            kwin::UNIT_FAHRENHEIT);
+  CHECK_NEAR(toFahrenheit.applyToDifference(10.0f), 18.0, 1e-5);
+  const kwin::LinearConversion<float> toKelvin =
+      kwin::getTemperatureConversion<float>(kwin::UNIT_CELSIUS,
+                                            kwin::UNIT_KELVIN);
+  CHECK(toKelvin.applyToDifference(10.0f) == 10.0f);
+}
+
+/* @brief A temperature keeps its unit and is converted when read. */
+void testTemperature() {
+  const kwin::Temperature<float> boiling(100.0f, kwin::UNIT_CELSIUS);
+  CHECK(boiling.getUnit() == kwin::UNIT_CELSIUS);
+  CHECK(boiling.getRawValue() == 100.0f);
+  CHECK(boiling.in(kwin::UNIT_CELSIUS) == 100.0f);
+  CHECK_NEAR(boiling.in(kwin::UNIT_FAHRENHEIT), 212.0, 1e-3);
+  CHECK_NEAR(boiling.in(kwin::UNIT_KELVIN), 373.15, 1e-3);
+}
+
+/*
+ * @brief A history stores every temperature in its own unit, whatever unit
+ * it was added in, one at a time or restored in bulk.
+ */
+void testTemperatureHistory() {
+  typedef kwin::TemperatureHistory<float, kwin::RingBuffer<float, 8>> History;
+  History history(kwin::UNIT_CELSIUS);
+  CHECK(history.getUnit() == kwin::UNIT_CELSIUS);
+
+  // Restored in fahrenheit, converted in place.
+  float restored[] = {32.0f, 212.0f};
+  history.append(restored, 2, kwin::UNIT_FAHRENHEIT);
+  history.push_back(kwin::Temperature<float>(20.0f, kwin::UNIT_CELSIUS));
+  history.push_back(kwin::Temperature<float>(273.15f, kwin::UNIT_KELVIN));
+
+  const kwin::RingBuffer<float, 8> &samples = history.getSamples();
+  CHECK(samples.size() == 4);
+  CHECK_NEAR(samples.at(0), 0.0, 1e-3);
+  CHECK_NEAR(samples.at(1), 100.0, 1e-3);
+  CHECK(samples.at(2) == 20.0f);
+  CHECK_NEAR(samples.at(3), 0.0, 1e-3);
+
+  const kwin::LinearConversion<float> toFahrenheit =
+      history.getConversionTo(kwin::UNIT_FAHRENHEIT);
+  CHECK_NEAR(toFahrenheit.apply(samples.at(2)), 68.0, 1e-3);
+}
+
+int main() {
+  testIntegerMatchesBaseline<int>();
+  testIntegerMatchesBaseline<long>();
+  testFloatMatchesBaseline();
+  testConvertTemperatures();
+  testDifferences();
+  testTemperature();
+  testTemperatureHistory();
+  return finishTests();
+}
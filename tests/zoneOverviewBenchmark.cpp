@@ -0,0 +1,190 @@
+/*
+ * Author: Kiwin Andersen.
+ */
+
+#include <chrono>
+#include <vector>
+
+#include "check.h"
+#include "kwin/sensors/dhtReader.h"
+#include "kwin/utils/eventLoop.h"
+#include "lcdMock.h"
+
+typedef std::chrono::steady_clock Clock;
+
+/*
+ * @brief Clock running at host speed while the event loop works, and jumping
+ * to the deadline while it idles, so a minute of the demo only takes as long
+ * as its work. Reads in progress finish at their deadline, waking the loop
+ * like the reader's Timeout.
+ */
+class HostClock : public kwin::EventClock {
+public:
+  HostClock() : start(Clock::now()), skippedUs(0), woken(false) {}
+
+  uint32_t nowUs() {
+    return skippedUs + (uint32_t)std::chrono::duration_cast<
+                           std::chrono::microseconds>(Clock::now() - start)
+                           .count();
+  }
+
+  void waitUntil(uint32_t deadlineUs) {
+    uint32_t readDeadlineUs = 0;
+    if (kwin::dhtReaderMockNextDeadline(&readDeadlineUs) &&
+        (int32_t)(readDeadlineUs - deadlineUs) < 0) {
+      deadlineUs = readDeadlineUs;
+    }
+    const int32_t remainingUs = deadlineUs - nowUs();
+    if (!woken && remainingUs > 0) {
+      skippedUs += remainingUs;
+    }
+    kwin::dhtReaderMockFinishReads(nowUs());
+    woken = false;
+  }
+
+  void wake() { woken = true; }
+
+private:
+  Clock::time_point start; // Host time of the clock's creation.
+  uint32_t skippedUs;      // Time skipped by idling.
+  bool woken;              // True if wake was called since the last wait.
+};
+
+// The demo's clock. The demo's event loop reads it as it is constructed, so
+// it's defined before the demo.
+HostClock hostClock;
+kwin::EventClock &zoneClock = hostClock;
+
+uint32_t us_ticker_read() { return hostClock.nowUs(); }
+
+#include "demos/zoneOverview.h"
+
+// As many zones as the overview lays out, more than the Arduino header fits.
+const ZoneConfig BENCHMARK_ZONES[MAX_ZONES] = {
+    {"Z1", D0},   {"Z2", D1},   {"Z3", D2},   {"Z4", D3},
+    {"Z5", D4},   {"Z6", D5},   {"Z7", D6},   {"Z8", D7},
+    {"Z9", D8},   {"Z10", D9},  {"Z11", D10}, {"Z12", D11},
+    {"Z13", D12}, {"Z14", D13}, {"Z15", D14}, {"Z16", D15}};
+
+// Simulated run time of the demo.
+const uint32_t RUN_US = 60000000;
+
+/*
+ * @brief Runs the demo with 16 zones for a minute. Every read starts in its
+ * slot, in zone order, and succeeds, and every zone keeps its readings.
+ */
+void benchmarkReads() {
+  initializeZones(BENCHMARK_ZONES, MAX_ZONES);
+  const uint32_t firstReadUs = nextZoneReadUs;
+  kwin::initializeLcdLayer();
+  renderZoneOverview();
+
+  std::vector<uint32_t> readCounts(MAX_ZONES, 0);
+  uint32_t reads = 0;
+  uint32_t maxJitterUs = 0;
+  uint64_t totalJitterUs = 0;
+  while ((int32_t)(hostClock.nowUs() - firstReadUs) < (int32_t)RUN_US) {
+    zoneEventLoop.runOnce();
+    for (int z = 0; z < MAX_ZONES; ++z) {
+      const kwin::DhtReader &sensor = *zones[z].sensor;
+      if (sensor.getReadCount() == readCounts[z]) {
+        continue;
+      }
+      CHECK(sensor.getReadCount() == readCounts[z] + 1);
+      CHECK(z == (int)(reads % MAX_ZONES));
+      readCounts[z] = sensor.getReadCount();
+
+      const uint32_t scheduledUs = firstReadUs + reads * zoneReadIntervalUs;
+      const int32_t lateUs = sensor.getLastStartUs() - scheduledUs;
+      CHECK(lateUs >= 0);
+      if (lateUs > 0) {
+        totalJitterUs += lateUs;
+        if ((uint32_t)lateUs > maxJitterUs) {
+          maxJitterUs = lateUs;
+        }
+      }
+      ++reads;
+    }
+  }
+
+  printf("%d zones, %lu reads in %lu s: read jitter max %lu us, mean %.1f us "
+         "of %lu us slots\n",
+         MAX_ZONES, (unsigned long)reads, (unsigned long)(RUN_US / 1000000),
+         (unsigned long)maxJitterUs, (double)totalJitterUs / reads,
+         (unsigned long)zoneReadIntervalUs);
+  CHECK(reads == RUN_US / zoneReadIntervalUs);
+  // A read starting a slot late would collide with the next one.
+  CHECK(maxJitterUs < zoneReadIntervalUs);
+
+  for (int z = 0; z < MAX_ZONES; ++z) {
+    const Zone &zone = zones[z];
+    CHECK(zone.failedReads == 0);
+    // Only the last read of a zone can still be in progress.
+    CHECK(zone.temperatures.size() + zone.sensor->isBusy() ==
+          zone.sensor->getReadCount());
+    CHECK(zone.humidity == 40.0f + BENCHMARK_ZONES[z].pin);
+  }
+}
+
+/*
+ * @brief Measures frames of the overview of 16 zones.
+ * @param name Name of the case, printed with the results.
+ * @param changedZones Zones with a new reading in every frame.
+ * @param fullRedraw True to redraw every frame completely.
+ */
+void benchmarkFrame(const char *name, int changedZones, bool fullRedraw) {
+  const int FRAMES = 200;
+  double totalUs = 0;
+  double maxUs = 0;
+  int64_t repaintedArea = 0;
+  for (int frame = 0; frame < FRAMES; ++frame) {
+    for (int z = 0; z < changedZones; ++z) {
+      const float temperature = 20.0f + (frame * 7 + z) % 50 * 0.1f;
+      zones[z].temperatures.push_back(temperature);
+      zones[z].temperatureStatistics.add(temperature);
+    }
+    if (fullRedraw) {
+      zoneDisplay.invalidate();
+    }
+
+    const Clock::time_point start = Clock::now();
+    renderZoneOverview();
+    const double us =
+        std::chrono::duration<double, std::micro>(Clock::now() - start)
+            .count();
+    totalUs += us;
+    maxUs = us > maxUs ? us : maxUs;
+    repaintedArea += zoneDisplay.getLastRepaintedArea();
+  }
+  printf("%-18s frame: mean %8.1f us, max %8.1f us, %5.1f%% of the screen "
+         "repainted\n",
+         name, totalUs / FRAMES, maxUs,
+         100.0 * repaintedArea / FRAMES /
+             (BSP_LCD_GetXSize() * BSP_LCD_GetYSize()));
+}
+
+/*
+ * @brief Frame times of the overview on the host. They don't carry over to
+ * the target, but show how the cost grows with the zones that change.
+ */
+void benchmarkFrames() {
+  benchmarkFrame("Unchanged", 0, false);
+  CHECK(zoneDisplay.getLastRepaintedArea() == 0);
+  benchmarkFrame("One zone changed", 1, false);
+  benchmarkFrame("All zones changed", MAX_ZONES, false);
+  benchmarkFrame("Full redraw", 0, true);
+
+  // With full histories, the sparklines are as long as they get. A frame
+  // overflowing the display list would be redrawn completely every time.
+  for (int z = 0; z < MAX_ZONES; ++z) {
+    CHECK(zones[z].temperatures.size() == ZONE_HISTORY_SAMPLES);
+  }
+  renderZoneOverview();
+  CHECK(zoneDisplay.getLastRepaintedArea() == 0);
+}
+
+int main() {
+  benchmarkReads();
+  benchmarkFrames();
+  return finishTests();
+}